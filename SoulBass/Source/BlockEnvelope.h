@@ -0,0 +1,200 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace soulbass
+{
+    //==============================================================================
+    // ADSR envelope generated a segment at a time.
+    //
+    // Every segment is an exponential approach computed by the recurrence
+    // v = base + v * coefficient: the attack aims past 1 so it arrives with a
+    // rounded knee, decay and release aim just below their targets so they land on
+    // time. Each segment's length is known in closed form, so render() fills a
+    // whole run of values with no per-sample state checks and stops exactly at the
+    // next boundary, where the caller can change loop variant.
+    //
+    // The release ends, and a sustain at that level counts as finished, once the
+    // envelope falls below the floor set with setFloor(): a voice doesn't pay for
+    // a tail nobody can hear.
+    class BlockEnvelope
+    {
+    public:
+        enum class Stage
+        {
+            idle = 0,
+            attack,
+            decay,
+            sustain,
+            release
+        };
+
+        void setSampleRate (double newSampleRate) noexcept
+        {
+            sampleRate = newSampleRate;
+            enterStage (stage);
+        }
+
+        // Times are in seconds, as juce::ADSR. Takes effect mid-segment.
+        void setParameters (const juce::ADSR::Parameters& newParameters) noexcept
+        {
+            if (newParameters.attack == parameters.attack && newParameters.decay == parameters.decay
+                && newParameters.sustain == parameters.sustain && newParameters.release == parameters.release)
+                return;
+
+            parameters = newParameters;
+
+            if (stage == Stage::sustain)
+                value = parameters.sustain;
+
+            enterStage (stage);
+        }
+
+        // Level below which the release is over.
+        void setFloor (float newFloor) noexcept
+        {
+            floor = juce::jmax (0.0f, newFloor);
+
+            if (stage == Stage::release)
+                enterStage (stage);
+        }
+
+        void noteOn() noexcept    { enterStage (Stage::attack); }
+        void noteOff() noexcept   { if (stage != Stage::idle) enterStage (Stage::release); }
+
+        void reset() noexcept
+        {
+            value = 0.0f;
+            enterStage (Stage::idle);
+        }
+
+        bool isActive() const noexcept
+        {
+            return stage != Stage::idle && ! (stage == Stage::sustain && value < floor);
+        }
+
+        Stage getStage() const noexcept { return stage; }
+        float getValue() const noexcept { return value; }
+
+        // Writes up to numSamples values into dest, stopping at the end of the
+        // current segment, and returns how many it wrote. Nothing is written while
+        // sustaining (the value is just getValue()) or idle.
+        int render (float* dest, int numSamples) noexcept
+        {
+            if (stage == Stage::idle || stage == Stage::sustain)
+                return 0;
+
+            const auto num = juce::jmin (numSamples, remaining);
+            auto v = value;
+
+            for (int i = 0; i < num; ++i)
+            {
+                v = base + v * coefficient;
+                dest[i] = v;
+            }
+
+            value = v;
+            remaining -= num;
+
+            // Land exactly on the segment's end level.
+            if (remaining == 0 && num > 0)
+            {
+                value = dest[num - 1] = endLevel;
+                enterStage (getNextStage());
+            }
+
+            return num;
+        }
+
+    private:
+        static constexpr double attackOvershoot = 0.3;
+        static constexpr double targetUndershoot = 1.0e-4;
+
+        Stage getNextStage() const noexcept
+        {
+            switch (stage)
+            {
+                case Stage::attack: return Stage::decay;
+                case Stage::decay:  return Stage::sustain;
+                case Stage::release:
+                case Stage::idle:   return Stage::idle;
+                case Stage::sustain: break;
+            }
+
+            return Stage::sustain;
+        }
+
+        // Sets up the recurrence that takes the current value to the stage's end
+        // level. Zero-length segments are passed straight through.
+        void enterStage (Stage newStage) noexcept
+        {
+            for (stage = newStage;; stage = getNextStage())
+            {
+                double seconds = 0.0, target = 0.0;
+
+                switch (stage)
+                {
+                    case Stage::idle:
+                        value = 0.0f;
+                        remaining = 0;
+                        return;
+
+                    case Stage::sustain:
+                        value = parameters.sustain;
+                        remaining = 0;
+                        return;
+
+                    case Stage::attack:
+                        seconds = parameters.attack;
+                        endLevel = 1.0f;
+                        target = 1.0 + attackOvershoot;
+                        break;
+
+                    case Stage::decay:
+                        seconds = parameters.decay;
+                        endLevel = parameters.sustain;
+                        target = parameters.sustain - targetUndershoot;
+                        break;
+
+                    case Stage::release:
+                        seconds = parameters.release;
+                        endLevel = juce::jmin (value, floor);
+                        target = -targetUndershoot;
+                        break;
+                }
+
+                const auto rate = seconds * sampleRate;
+                const auto span = stage == Stage::attack ? 1.0 : (stage == Stage::decay ? 1.0 - parameters.sustain : 1.0);
+                const auto overshoot = stage == Stage::attack ? attackOvershoot : targetUndershoot;
+
+                // Already there, or no time to get there.
+                if (rate < 1.0 || (stage == Stage::attack ? value >= endLevel : value <= endLevel) || span <= 0.0)
+                {
+                    value = endLevel;
+                    continue;
+                }
+
+                // A full-range segment (0 to 1 for the attack, 1 to the target
+                // otherwise) takes `rate` samples, as with a linear ADSR.
+                const auto c = std::exp (-std::log ((span + overshoot) / overshoot) / rate);
+                coefficient = (float) c;
+                base = (float) (target * (1.0 - c));
+
+                // Samples from here to the end level: target + (value - target) c^n.
+                const auto n = std::log ((endLevel - target) / ((double) value - target)) / std::log (c);
+                remaining = juce::jmax (1, (int) std::ceil (n));
+                return;
+            }
+        }
+
+        juce::ADSR::Parameters parameters { 0.0f, 0.0f, 1.0f, 0.0f };
+        double sampleRate = 44100.0;
+        float floor = 0.0f;
+
+        Stage stage = Stage::idle;
+        float value = 0.0f;
+        float endLevel = 0.0f;
+        float coefficient = 0.0f, base = 0.0f;
+        int remaining = 0;
+    };
+} // namespace soulbass
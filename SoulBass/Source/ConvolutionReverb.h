@@ -0,0 +1,174 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BinaryData.h"
+
+namespace soulbass
+{
+    //==============================================================================
+    // Convolution alternative to the algorithmic juce::dsp::Reverb.
+    //
+    // Uses a non-uniform partitioned juce::dsp::Convolution: a small head partition
+    // keeps the engine at zero latency while the tail runs in larger FFT partitions.
+    // Impulse responses are decoded from BinaryData and decay-shaped on a loader
+    // thread; the convolver then resamples them and crossfades them in on its own
+    // background queue, so the audio thread only ever records what it wants.
+    class ConvolutionReverb
+    {
+    public:
+        enum class Impulse
+        {
+            spring = 0,
+            plate
+        };
+
+        ConvolutionReverb() : loader (*this) {}
+
+        ~ConvolutionReverb()
+        {
+            loader.stopThread (2000);
+        }
+
+        void prepare (const juce::dsp::ProcessSpec& spec)
+        {
+            convolution.prepare (spec);
+            mixer.prepare (spec);
+            mixer.setMixingRule (juce::dsp::DryWetMixingRule::balanced);
+
+            if (! loader.isThreadRunning())
+                loader.startThread();
+        }
+
+        void reset()
+        {
+            convolution.reset();
+            mixer.reset();
+        }
+
+        // Safe to call from the audio thread: only stores the request, the loader
+        // thread rebuilds the impulse response when it changes.
+        void setParameters (Impulse impulse, float decaySeconds, float blend)
+        {
+            requestedImpulse.store ((int) impulse);
+            requestedDecay.store (decaySeconds);
+            mixer.setWetMixProportion (juce::jlimit (0.0f, 1.0f, blend));
+        }
+
+        void process (const juce::dsp::ProcessContextReplacing<float>& context)
+        {
+            mixer.pushDrySamples (context.getInputBlock());
+            convolution.process (context);
+            mixer.mixWetSamples (context.getOutputBlock());
+        }
+
+    private:
+        static constexpr int headSizeSamples = 256;
+
+        class Loader : public juce::Thread
+        {
+        public:
+            explicit Loader (ConvolutionReverb& ownerIn)
+                : juce::Thread ("SoulBass IR Loader"), owner (ownerIn)
+            {
+            }
+
+            void run() override
+            {
+                while (! threadShouldExit())
+                {
+                    const auto impulse = owner.requestedImpulse.load();
+                    const auto decay = owner.requestedDecay.load();
+
+                    if (impulse != loadedImpulse || std::abs (decay - loadedDecay) > 0.02f)
+                    {
+                        if (auto* source = getDecoded (impulse))
+                        {
+                            auto shaped = makeShapedImpulse (*source, decay);
+                            owner.convolution.loadImpulseResponse (std::move (shaped),
+                                                                   sourceSampleRate,
+                                                                   juce::dsp::Convolution::Stereo::yes,
+                                                                   juce::dsp::Convolution::Trim::yes,
+                                                                   juce::dsp::Convolution::Normalise::yes);
+                        }
+
+                        loadedImpulse = impulse;
+                        loadedDecay = decay;
+                    }
+
+                    wait (50);
+                }
+            }
+
+        private:
+            const juce::AudioBuffer<float>* getDecoded (int impulse)
+            {
+                auto& slot = decoded[(size_t) juce::jlimit (0, 1, impulse)];
+
+                if (slot.getNumSamples() == 0)
+                {
+                    const bool isSpring = impulse == (int) Impulse::spring;
+                    const auto* data = isSpring ? BinaryData::Spring_IR_wav : BinaryData::Plate_IR_wav;
+                    const auto size = isSpring ? BinaryData::Spring_IR_wavSize : BinaryData::Plate_IR_wavSize;
+
+                    std::unique_ptr<juce::AudioFormatReader> reader (
+                        wavFormat.createReaderFor (new juce::MemoryInputStream (data, (size_t) size, false), true));
+
+                    if (reader == nullptr)
+                        return nullptr;
+
+                    const auto length = (int) reader->lengthInSamples;
+                    slot.setSize (2, length);
+                    reader->read (&slot, 0, length, 0, true, true);
+
+                    // Mono IRs feed both channels of the stereo convolver.
+                    if (reader->numChannels == 1)
+                        slot.copyFrom (1, 0, slot, 0, 0, length);
+
+                    sourceSampleRate = reader->sampleRate;
+                }
+
+                return &slot;
+            }
+
+            juce::AudioBuffer<float> makeShapedImpulse (const juce::AudioBuffer<float>& source, float decaySeconds) const
+            {
+                juce::AudioBuffer<float> shaped (source);
+
+                // Pull the recorded tail in towards the requested decay (-60 dB point).
+                const auto samplesPerDecay = juce::jmax (1.0, (double) decaySeconds * sourceSampleRate);
+                const auto step = (float) std::exp (-6.9 / samplesPerDecay);
+
+                for (int ch = 0; ch < shaped.getNumChannels(); ++ch)
+                {
+                    auto* data = shaped.getWritePointer (ch);
+                    float gain = 1.0f;
+
+                    for (int i = 0; i < shaped.getNumSamples(); ++i)
+                    {
+                        data[i] *= gain;
+                        gain *= step;
+                    }
+                }
+
+                return shaped;
+            }
+
+            ConvolutionReverb& owner;
+            juce::WavAudioFormat wavFormat;
+            std::array<juce::AudioBuffer<float>, 2> decoded;
+            double sourceSampleRate = 44100.0;
+            int loadedImpulse = -1;
+            float loadedDecay = -1.0f;
+        };
+
+        juce::dsp::Convolution convolution { juce::dsp::Convolution::NonUniform { headSizeSamples } };
+        juce::dsp::DryWetMixer<float> mixer;
+
+        std::atomic<int> requestedImpulse { (int) Impulse::spring };
+        std::atomic<float> requestedDecay { 1.5f };
+
+        Loader loader;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolutionReverb)
+    };
+} // namespace soulbass
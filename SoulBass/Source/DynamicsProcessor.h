@@ -0,0 +1,372 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "FastMath.h"
+
+namespace soulbass
+{
+    //==============================================================================
+    // Stereo-linked compressor / lookahead true-peak limiter.
+    //
+    // The detector runs once per sample frame on max(|L|, |R|), so both channels
+    // always receive the same gain. The static curve and the dB <-> gain
+    // conversions run as flat loops over scratch arrays (vectorisable); only the
+    // ballistics are serial.
+    //
+    // Limit mode detects inter-sample peaks with a 4x polyphase interpolator, holds
+    // the minimum target gain over the lookahead window and smooths it with a box
+    // filter of the same length, so the gain has fully settled by the time the
+    // (delayed) peak reaches the output.
+    class DynamicsProcessor
+    {
+    public:
+        enum class Mode
+        {
+            compress = 0,
+            limit
+        };
+
+        static constexpr float maxLookaheadMs = 10.0f;
+
+        void prepare (const juce::dsp::ProcessSpec& spec)
+        {
+            sampleRate = spec.sampleRate;
+            numChannels = (int) juce::jmin ((juce::uint32) 2, spec.numChannels);
+            maxBlockSize = (int) spec.maximumBlockSize;
+
+            detector.assign ((size_t) maxBlockSize, 0.0f);
+            gains.assign ((size_t) maxBlockSize, 0.0f);
+
+            maxLookaheadSamples = (int) std::ceil (maxLookaheadMs * 0.001 * sampleRate);
+            const auto delaySize = (size_t) (maxLookaheadSamples + truePeakLatency + 1);
+            for (auto& d : delayBuffers)
+                d.assign (delaySize, 0.0f);
+
+            holdValues.assign ((size_t) maxLookaheadSamples + 2, 1.0f);
+            holdStamps.assign ((size_t) maxLookaheadSamples + 2, 0);
+            boxValues.assign ((size_t) maxLookaheadSamples + 1, 1.0f);
+            lookaheadSamples = juce::jmin (lookaheadSamples, maxLookaheadSamples);
+
+            designTruePeakFilter();
+            updateCoefficients();
+            reset();
+        }
+
+        void reset()
+        {
+            for (auto& d : delayBuffers)
+                std::fill (d.begin(), d.end(), 0.0f);
+
+            for (auto& h : tpHistory)
+                h.fill (0.0f);
+
+            std::fill (boxValues.begin(), boxValues.end(), 1.0f);
+            boxSum = (double) lookaheadSamples;
+            boxIndex = 0;
+            holdHead = holdTail = 0;
+            frameCounter = 0;
+            delayIndex = 0;
+            tpIndex = 0;
+
+            envelopeDb = 0.0f;
+            limiterGain = 1.0f;
+            gainReductionDb.store (0.0f);
+        }
+
+        void setParameters (Mode newMode, float thresholdDb, float newRatio,
+                            float attackMs, float releaseMs, float lookaheadMs)
+        {
+            if (newMode != mode)
+            {
+                mode = newMode;
+                reset();
+            }
+
+            threshold = thresholdDb;
+            ratio = juce::jmax (1.0f, newRatio);
+            attackTimeMs = juce::jmax (0.01f, attackMs);
+            releaseTimeMs = juce::jmax (1.0f, releaseMs);
+
+            const auto newLookahead = juce::jlimit (0, maxLookaheadSamples,
+                                                    (int) std::round (lookaheadMs * 0.001 * sampleRate));
+            if (newLookahead != lookaheadSamples)
+            {
+                lookaheadSamples = newLookahead;
+                reset();
+            }
+
+            updateCoefficients();
+        }
+
+        // Exact dB conversions instead of the fast approximations, for the reference
+        // render path. Only the compressor's gain computer is affected.
+        void setExactMath (bool shouldUseExactMath) noexcept { exactMath = shouldUseExactMath; }
+
+        // Latency the limiter adds to the signal path; the compressor adds none.
+        int getLatencySamples() const noexcept
+        {
+            return mode == Mode::limit ? lookaheadSamples + truePeakLatency : 0;
+        }
+
+        // How long after the input falls silent the output can still change: the
+        // limiter's delay and hold, then five release time constants, by which
+        // point any gain reduction has recovered to within a fraction of a dB.
+        int getTailSamples() const noexcept
+        {
+            const auto hold = mode == Mode::limit ? lookaheadSamples : 0;
+            return getLatencySamples() + hold + (int) std::ceil (5.0 * releaseTimeMs * 0.001 * sampleRate);
+        }
+
+        // Deepest gain reduction of the last block, in dB (<= 0). Safe from any thread.
+        float getGainReductionDb() const noexcept { return gainReductionDb.load (std::memory_order_relaxed); }
+
+        void process (const juce::dsp::ProcessContextReplacing<float>& context)
+        {
+            auto& block = context.getOutputBlock();
+            const auto totalSamples = (int) block.getNumSamples();
+            const auto channels = juce::jmin (numChannels, (int) block.getNumChannels());
+
+            if (channels == 0 || totalSamples == 0 || maxBlockSize == 0)
+                return;
+
+            float deepestGain = 1.0f;
+
+            for (int offset = 0; offset < totalSamples; offset += maxBlockSize)
+            {
+                const auto num = juce::jmin (maxBlockSize, totalSamples - offset);
+                float* data[2] { block.getChannelPointer (0) + offset,
+                                 block.getChannelPointer ((size_t) (channels - 1)) + offset };
+
+                if (mode == Mode::limit)
+                    processLimiter (data, channels, num);
+                else
+                    processCompressor (data, channels, num);
+
+                deepestGain = juce::jmin (deepestGain, juce::FloatVectorOperations::findMinimum (gains.data(), num));
+            }
+
+            gainReductionDb.store (fastGainToDecibels (deepestGain), std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr int truePeakOversampling = 4;
+        static constexpr int truePeakTapsPerPhase = 8;
+        static constexpr int truePeakLatency = truePeakTapsPerPhase / 2;
+        static constexpr float kneeDb = 6.0f;
+
+        void updateCoefficients()
+        {
+            const auto sr = (float) juce::jmax (1.0, sampleRate);
+            attackCoeff = 1.0f - std::exp (-1.0f / (attackTimeMs * 0.001f * sr));
+            releaseCoeff = 1.0f - std::exp (-1.0f / (releaseTimeMs * 0.001f * sr));
+        }
+
+        void designTruePeakFilter()
+        {
+            // Windowed-sinc 4x interpolator; phase 0 reduces to a pure delay.
+            constexpr int numTaps = truePeakOversampling * truePeakTapsPerPhase;
+            constexpr float centre = (float) (numTaps / 2);
+
+            for (int i = 0; i < numTaps; ++i)
+            {
+                const auto t = ((float) i - centre) / (float) truePeakOversampling;
+                const auto sinc = t == 0.0f ? 1.0f
+                                            : std::sin (juce::MathConstants<float>::pi * t) / (juce::MathConstants<float>::pi * t);
+                const auto window = 0.5f + 0.5f * std::cos (juce::MathConstants<float>::pi * ((float) i - centre) / (centre + 1.0f));
+                tpTaps[(size_t) (i % truePeakOversampling)][(size_t) (i / truePeakOversampling)] = sinc * window;
+            }
+        }
+
+        //==============================================================================
+        void processCompressor (float* const* data, int channels, int num)
+        {
+            auto* level = detector.data();
+            auto* gain = gains.data();
+
+            // Stereo-linked peak detector, computed once for both channels.
+            juce::FloatVectorOperations::abs (level, data[0], num);
+            if (channels > 1)
+                for (int i = 0; i < num; ++i)
+                    level[i] = juce::jmax (level[i], std::abs (data[1][i]));
+
+            // Static curve with a soft knee, in dB.
+            const auto slope = 1.0f / ratio - 1.0f;
+            const auto halfKnee = kneeDb * 0.5f;
+            const auto thresholdLocal = threshold;
+
+            if (exactMath)
+                for (int i = 0; i < num; ++i)
+                    level[i] = juce::Decibels::gainToDecibels (level[i], -120.0f);
+            else
+                for (int i = 0; i < num; ++i)
+                    level[i] = fastGainToDecibels (level[i]);
+
+            for (int i = 0; i < num; ++i)
+            {
+                const auto over = level[i] - thresholdLocal;
+                const auto inKnee = juce::jlimit (0.0f, kneeDb, over + halfKnee);
+                gain[i] = slope * (inKnee * inKnee / (2.0f * kneeDb) + juce::jmax (0.0f, over - halfKnee));
+            }
+
+            // Attack/release ballistics on the gain reduction.
+            auto env = envelopeDb;
+            for (int i = 0; i < num; ++i)
+            {
+                const auto coeff = gain[i] < env ? attackCoeff : releaseCoeff;
+                env += coeff * (gain[i] - env);
+                gain[i] = env;
+            }
+            envelopeDb = env;
+
+            if (exactMath)
+                for (int i = 0; i < num; ++i)
+                    gain[i] = juce::Decibels::decibelsToGain (gain[i], -1000.0f);
+            else
+                for (int i = 0; i < num; ++i)
+                    gain[i] = fastDecibelsToGain (gain[i]);
+
+            for (int ch = 0; ch < channels; ++ch)
+                juce::FloatVectorOperations::multiply (data[ch], gain, num);
+        }
+
+        //==============================================================================
+        void processLimiter (float* const* data, int channels, int num)
+        {
+            auto* peak = detector.data();
+            auto* gain = gains.data();
+
+            detectTruePeaks (data, channels, num);
+
+            // Target gain that keeps the detected peak at the threshold.
+            const auto ceiling = juce::Decibels::decibelsToGain (threshold);
+            for (int i = 0; i < num; ++i)
+                gain[i] = juce::jmin (1.0f, ceiling / juce::jmax (peak[i], 1.0e-9f));
+
+            const auto window = lookaheadSamples;
+            const auto holdCapacity = (int) holdValues.size();
+            const auto delaySize = (int) delayBuffers[0].size();
+            const auto delay = lookaheadSamples + truePeakLatency;
+
+            for (int i = 0; i < num; ++i)
+            {
+                // Sliding minimum over the lookahead window (monotonic queue).
+                const auto target = gain[i];
+                while (holdHead != holdTail)
+                {
+                    const auto back = (holdTail + holdCapacity - 1) % holdCapacity;
+                    if (holdValues[(size_t) back] < target)
+                        break;
+                    holdTail = back;
+                }
+                holdValues[(size_t) holdTail] = target;
+                holdStamps[(size_t) holdTail] = frameCounter;
+                holdTail = (holdTail + 1) % holdCapacity;
+
+                while (holdStamps[(size_t) holdHead] < frameCounter - window)
+                    holdHead = (holdHead + 1) % holdCapacity;
+
+                const auto held = holdValues[(size_t) holdHead];
+                ++frameCounter;
+
+                // Instant attack, exponential release.
+                limiterGain = held < limiterGain ? held : limiterGain + releaseCoeff * (held - limiterGain);
+
+                // Box smoothing spreads the attack across the lookahead window.
+                auto smoothed = limiterGain;
+                if (window > 0)
+                {
+                    boxSum += (double) limiterGain - (double) boxValues[(size_t) boxIndex];
+                    boxValues[(size_t) boxIndex] = limiterGain;
+                    boxIndex = (boxIndex + 1) % window;
+                    smoothed = (float) (boxSum / (double) window);
+                }
+
+                gain[i] = smoothed;
+
+                const auto readIndex = (delayIndex + delaySize - delay) % delaySize;
+                for (int ch = 0; ch < channels; ++ch)
+                {
+                    auto& line = delayBuffers[(size_t) ch];
+                    line[(size_t) delayIndex] = data[ch][i];
+                    data[ch][i] = line[(size_t) readIndex] * smoothed;
+                }
+
+                delayIndex = (delayIndex + 1) % delaySize;
+            }
+        }
+
+        void detectTruePeaks (float* const* data, int channels, int num)
+        {
+            auto* peak = detector.data();
+            std::fill (peak, peak + num, 0.0f);
+
+            for (int ch = 0; ch < channels; ++ch)
+            {
+                auto& history = tpHistory[(size_t) ch];
+                auto index = tpIndex;
+
+                for (int i = 0; i < num; ++i)
+                {
+                    history[(size_t) index] = data[ch][i];
+                    history[(size_t) (index + truePeakTapsPerPhase)] = data[ch][i];
+                    index = (index + 1) % truePeakTapsPerPhase;
+
+                    // history[index .. index + taps) now holds the newest taps, oldest first.
+                    const auto* window = history.data() + index;
+                    float framePeak = 0.0f;
+
+                    for (const auto& phase : tpTaps)
+                    {
+                        float acc = 0.0f;
+                        for (int k = 0; k < truePeakTapsPerPhase; ++k)
+                            acc += phase[(size_t) k] * window[truePeakTapsPerPhase - 1 - k];
+                        framePeak = juce::jmax (framePeak, std::abs (acc));
+                    }
+
+                    peak[i] = juce::jmax (peak[i], framePeak);
+                }
+            }
+
+            tpIndex = (tpIndex + num) % truePeakTapsPerPhase;
+        }
+
+        //==============================================================================
+        double sampleRate = 44100.0;
+        int numChannels = 2;
+        int maxBlockSize = 0;
+
+        Mode mode = Mode::compress;
+        bool exactMath = false;
+        float threshold = -12.0f;
+        float ratio = 4.0f;
+        float attackTimeMs = 10.0f;
+        float releaseTimeMs = 80.0f;
+        float attackCoeff = 0.0f;
+        float releaseCoeff = 0.0f;
+
+        std::vector<float> detector, gains;
+
+        // Compressor state
+        float envelopeDb = 0.0f;
+
+        // Limiter state
+        int maxLookaheadSamples = 0;
+        int lookaheadSamples = 0;
+        std::array<std::vector<float>, 2> delayBuffers;
+        int delayIndex = 0;
+        std::vector<float> holdValues;
+        std::vector<juce::int64> holdStamps;
+        int holdHead = 0, holdTail = 0;
+        juce::int64 frameCounter = 0;
+        std::vector<float> boxValues;
+        double boxSum = 0.0;
+        int boxIndex = 0;
+        float limiterGain = 1.0f;
+
+        std::array<std::array<float, (size_t) truePeakTapsPerPhase>, (size_t) truePeakOversampling> tpTaps {};
+        std::array<std::array<float, (size_t) truePeakTapsPerPhase * 2>, 2> tpHistory {};
+        int tpIndex = 0;
+
+        std::atomic<float> gainReductionDb { 0.0f };
+    };
+} // namespace soulbass
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace soulbass
+{
+    //==============================================================================
+    // Multi-tap ensemble chorus.
+    //
+    // Each side runs up to four modulated taps off one delay line. All taps share a
+    // single sine table and one phase accumulator; they differ only by a fixed phase
+    // and centre-delay offset, so the per-tap work is a table read and a fractional
+    // delay read. Taps are laid out as lanes in fixed four-wide arrays, and only
+    // the selected number of voices is computed; the delay-line reads are done tap
+    // by tap, as scalar loads.
+    //
+    // A Linkwitz-Riley crossover keeps everything below the split frequency mono
+    // and dry, so the sub never smears.
+    class EnsembleChorus
+    {
+    public:
+        static constexpr int maxVoices = 4;
+
+        EnsembleChorus()
+        {
+            for (int i = 0; i <= tableSize; ++i)
+                sineTable[(size_t) i] = std::sin (juce::MathConstants<float>::twoPi * (float) i / (float) tableSize);
+        }
+
+        void prepare (const juce::dsp::ProcessSpec& spec)
+        {
+            sampleRate = spec.sampleRate;
+
+            const auto maxDelaySamples = (centreDelayMs + voiceSpreadMs + depthMs) * 0.001 * sampleRate;
+            const auto size = juce::nextPowerOfTwo ((int) std::ceil (maxDelaySamples) + 4);
+            mask = size - 1;
+
+            for (auto& line : lines)
+                line.assign ((size_t) size, 0.0f);
+
+            crossover.prepare (spec);
+            crossover.setCutoffFrequency (crossoverHz);
+
+            updateLanes();
+            reset();
+        }
+
+        void reset()
+        {
+            for (auto& line : lines)
+                std::fill (line.begin(), line.end(), 0.0f);
+
+            crossover.reset();
+            writeIndex = 0;
+            phase = 0.0f;
+        }
+
+        void setParameters (float rateHz, float mixIn, int voicesIn, float crossoverFrequency)
+        {
+            phaseIncrement = (float) tableSize * juce::jmax (0.0f, rateHz) / (float) juce::jmax (1.0, sampleRate);
+            mix = juce::jlimit (0.0f, 1.0f, mixIn);
+
+            const auto newVoices = juce::jlimit (2, maxVoices, voicesIn);
+            if (newVoices != numVoices)
+            {
+                numVoices = newVoices;
+                updateLanes();
+            }
+
+            if (crossoverFrequency != crossoverHz)
+            {
+                crossoverHz = crossoverFrequency;
+                crossover.setCutoffFrequency (crossoverHz);
+            }
+        }
+
+        void process (const juce::dsp::ProcessContextReplacing<float>& context)
+        {
+            auto& block = context.getOutputBlock();
+            const auto numSamples = (int) block.getNumSamples();
+            auto* left = block.getChannelPointer (0);
+            auto* right = block.getNumChannels() > 1 ? block.getChannelPointer (1) : nullptr;
+
+            auto& lineL = lines[0];
+            auto& lineR = lines[1];
+            const auto dryGain = 1.0f - mix;
+            const auto wetGain = mix * wetNormalisation;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                float lowL, highL, lowR, highR;
+                crossover.processSample (0, left[i], lowL, highL);
+
+                if (right != nullptr)
+                {
+                    crossover.processSample (1, right[i], lowR, highR);
+                }
+                else
+                {
+                    lowR = lowL;
+                    highR = highL;
+                }
+
+                lineL[(size_t) writeIndex] = highL;
+                lineR[(size_t) writeIndex] = highR;
+
+                // Shared modulation: one phase, one table, per-lane offsets.
+                std::array<float, maxVoices> delayL, delayR;
+                for (int lane = 0; lane < numVoices; ++lane)
+                {
+                    delayL[(size_t) lane] = lfoDelay (lane, 0);
+                    delayR[(size_t) lane] = lfoDelay (lane, 1);
+                }
+
+                float wetL = 0.0f, wetR = 0.0f;
+                for (int lane = 0; lane < numVoices; ++lane)
+                {
+                    wetL += readFractional (lineL, delayL[(size_t) lane]);
+                    wetR += readFractional (lineR, delayR[(size_t) lane]);
+                }
+
+                const auto lowMono = 0.5f * (lowL + lowR);
+                left[i] = lowMono + highL * dryGain + wetL * wetGain;
+                if (right != nullptr)
+                    right[i] = lowMono + highR * dryGain + wetR * wetGain;
+
+                writeIndex = (writeIndex + 1) & mask;
+                phase += phaseIncrement;
+                if (phase >= (float) tableSize)
+                    phase -= (float) tableSize;
+            }
+        }
+
+    private:
+        static constexpr int tableSize = 1024;
+        static constexpr float centreDelayMs = 7.5f;
+        static constexpr float depthMs = 1.8f;
+        static constexpr float voiceSpreadMs = 2.5f;
+
+        void updateLanes()
+        {
+            const auto msToSamples = (float) (0.001 * sampleRate);
+
+            for (int lane = 0; lane < maxVoices; ++lane)
+            {
+                const auto spread = numVoices > 1 ? (float) lane / (float) (numVoices - 1) : 0.5f;
+
+                laneCentre[(size_t) lane] = (centreDelayMs + (spread - 0.5f) * voiceSpreadMs) * msToSamples;
+
+                // Spread voices evenly round the cycle; the right side sits a quarter
+                // cycle behind so the image widens instead of panning.
+                const auto offset = (float) lane / (float) juce::jmax (1, numVoices) * (float) tableSize;
+                lanePhase[0][(size_t) lane] = offset;
+                lanePhase[1][(size_t) lane] = std::fmod (offset + 0.25f * (float) tableSize, (float) tableSize);
+            }
+
+            depthSamples = depthMs * msToSamples;
+            wetNormalisation = 1.0f / std::sqrt ((float) numVoices);
+        }
+
+        float lfoDelay (int lane, int side) const noexcept
+        {
+            auto p = phase + lanePhase[(size_t) side][(size_t) lane];
+            p -= p >= (float) tableSize ? (float) tableSize : 0.0f;
+
+            const auto index = (int) p;
+            const auto frac = p - (float) index;
+            const auto a = sineTable[(size_t) index];
+            const auto b = sineTable[(size_t) index + 1];
+
+            return laneCentre[(size_t) lane] + depthSamples * (a + frac * (b - a));
+        }
+
+        float readFractional (const std::vector<float>& line, float delaySamples) const noexcept
+        {
+            const auto position = (float) writeIndex - delaySamples;
+            const auto floored = std::floor (position);
+            const auto frac = position - floored;
+            const auto index = (int) floored;
+
+            const auto a = line[(size_t) (index & mask)];
+            const auto b = line[(size_t) ((index + 1) & mask)];
+            return a + frac * (b - a);
+        }
+
+        double sampleRate = 44100.0;
+
+        std::array<float, (size_t) tableSize + 1> sineTable {};
+        std::array<std::vector<float>, 2> lines;
+        int mask = 0;
+        int writeIndex = 0;
+
+        float phase = 0.0f;
+        float phaseIncrement = 0.0f;
+        float mix = 0.35f;
+        int numVoices = 3;
+        float depthSamples = 0.0f;
+        float wetNormalisation = 1.0f;
+
+        std::array<float, maxVoices> laneCentre {};
+        std::array<std::array<float, maxVoices>, 2> lanePhase {};
+
+        float crossoverHz = 150.0f;
+        juce::dsp::LinkwitzRileyFilter<float> crossover;
+    };
+} // namespace soulbass
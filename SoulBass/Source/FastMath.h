@@ -0,0 +1,50 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace soulbass
+{
+    //==============================================================================
+    // Branch-free log2/exp2 approximations for block loops. They work on the float
+    // bit pattern so the compiler can keep whole loops in vector registers; accuracy
+    // is around 0.03 dB, which is plenty for gain computers and control signals.
+    inline float fastLog2 (float x) noexcept
+    {
+        juce::uint32 bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+
+        const auto exponent = (float) ((juce::int32) ((bits >> 23) & 0xff) - 127);
+        bits = (bits & 0x007fffffu) | 0x3f800000u;
+
+        float mantissa;
+        std::memcpy (&mantissa, &bits, sizeof (mantissa));
+
+        return exponent + (-0.34484843f * mantissa + 2.02466578f) * mantissa - 1.67487759f;
+    }
+
+    inline float fastExp2 (float x) noexcept
+    {
+        x = juce::jlimit (-126.0f, 126.0f, x);
+
+        const auto whole = std::floor (x);
+        const auto frac = x - whole;
+        const auto poly = 1.0f + frac * (0.6960656f + frac * (0.2244943f + frac * 0.0792043f));
+
+        auto bits = (juce::uint32) ((juce::int32) whole + 127) << 23;
+        float scale;
+        std::memcpy (&scale, &bits, sizeof (scale));
+
+        return scale * poly;
+    }
+
+    // 20 * log10 (x) == 6.0206 * log2 (x)
+    inline float fastGainToDecibels (float gain, float floorDb = -120.0f) noexcept
+    {
+        return juce::jmax (floorDb, 6.02059991f * fastLog2 (juce::jmax (gain, 1.0e-9f)));
+    }
+
+    inline float fastDecibelsToGain (float decibels) noexcept
+    {
+        return fastExp2 (decibels * 0.16609640f);
+    }
+} // namespace soulbass
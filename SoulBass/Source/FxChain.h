@@ -0,0 +1,324 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "FxKernels.h"
+
+namespace soulbass
+{
+    //==============================================================================
+    // Reorderable FX stages between the fixed input and output gains.
+    enum class FxStage : juce::uint8
+    {
+        eq = 0,
+        dynamics,
+        shaper,
+        chorus,
+        delay,
+        reverb
+    };
+
+    constexpr int numFxStages = 6;
+    using FxOrder = std::array<FxStage, (size_t) numFxStages>;
+
+    inline FxOrder getDefaultFxOrder()
+    {
+        return { FxStage::eq, FxStage::dynamics, FxStage::shaper, FxStage::chorus, FxStage::delay, FxStage::reverb };
+    }
+
+    inline const char* getFxStageId (FxStage stage)
+    {
+        switch (stage)
+        {
+            case FxStage::eq:       return "eq";
+            case FxStage::dynamics: return "dyn";
+            case FxStage::shaper:   return "shaper";
+            case FxStage::chorus:   return "chorus";
+            case FxStage::delay:    return "delay";
+            case FxStage::reverb:   return "reverb";
+        }
+
+        return "";
+    }
+
+    // The APVTS "...Enabled" parameter that bypasses each stage.
+    inline const char* getFxStageEnableParameter (FxStage stage)
+    {
+        switch (stage)
+        {
+            case FxStage::eq:       return "eqEnabled";
+            case FxStage::dynamics: return "dynEnabled";
+            case FxStage::shaper:   return "shaperEnabled";
+            case FxStage::chorus:   return "chorusEnabled";
+            case FxStage::delay:    return "delayEnabled";
+            case FxStage::reverb:   return "reverbEnabled";
+        }
+
+        return "";
+    }
+
+    inline juce::String fxOrderToString (const FxOrder& order)
+    {
+        juce::StringArray ids;
+        for (auto stage : order)
+            ids.add (getFxStageId (stage));
+        return ids.joinIntoString (",");
+    }
+
+    // Parses "eq,dyn,shaper,...". Must name every stage exactly once.
+    inline bool fxOrderFromString (const juce::String& text, FxOrder& result)
+    {
+        juce::StringArray ids;
+        ids.addTokens (text, ",", "");
+        ids.trim();
+        ids.removeEmptyStrings();
+
+        if (ids.size() != numFxStages)
+            return false;
+
+        FxOrder parsed {};
+        std::array<bool, (size_t) numFxStages> seen {};
+
+        for (int i = 0; i < numFxStages; ++i)
+        {
+            int found = -1;
+            for (int s = 0; s < numFxStages; ++s)
+                if (ids[i] == getFxStageId ((FxStage) s))
+                    found = s;
+
+            if (found < 0 || seen[(size_t) found])
+                return false;
+
+            seen[(size_t) found] = true;
+            parsed[(size_t) i] = (FxStage) found;
+        }
+
+        result = parsed;
+        return true;
+    }
+
+    //==============================================================================
+    // A compiled chain: a flat list of steps with bypassed stages removed and
+    // neighbouring per-sample stages merged into single fused passes. It packs into
+    // 64 bits so it can be published to the audio thread with one atomic store.
+    struct FxProgram
+    {
+        enum Op : juce::uint8
+        {
+            dynamicsOp = 1,
+            chorusOp,
+            delayOp,
+            reverbOp,
+
+            // fusedOp | inputGainFlag | outputGainFlag | (FusedMiddle << middleShift)
+            fusedOp = 0x80,
+            inputGainFlag = 0x01,
+            outputGainFlag = 0x02
+        };
+
+        static constexpr int middleShift = 2;
+
+        // Worst case: four block stages interleaved with input gain, EQ, shaper and
+        // output gain runs. A zero byte ends the list, since no op encodes as zero.
+        static constexpr int maxSteps = 8;
+
+        std::array<juce::uint8, (size_t) maxSteps> steps {};
+        int numSteps = 0;
+
+        static bool isFused (juce::uint8 op) noexcept              { return (op & fusedOp) != 0; }
+        static bool hasInputGain (juce::uint8 op) noexcept         { return (op & inputGainFlag) != 0; }
+        static bool hasOutputGain (juce::uint8 op) noexcept        { return (op & outputGainFlag) != 0; }
+        static FusedMiddle getMiddle (juce::uint8 op) noexcept     { return (FusedMiddle) ((op >> middleShift) & 0x07); }
+
+        const juce::uint8* begin() const noexcept { return steps.data(); }
+        const juce::uint8* end() const noexcept   { return steps.data() + numSteps; }
+
+        juce::uint64 pack() const noexcept
+        {
+            static_assert (sizeof (juce::uint64) == maxSteps, "steps must fill the packed word");
+
+            juce::uint64 packed;
+            std::memcpy (&packed, steps.data(), sizeof (packed));
+            return packed;
+        }
+
+        static FxProgram unpack (juce::uint64 packed) noexcept
+        {
+            FxProgram p;
+            std::memcpy (p.steps.data(), &packed, sizeof (packed));
+
+            while (p.numSteps < maxSteps && p.steps[(size_t) p.numSteps] != 0)
+                ++p.numSteps;
+
+            return p;
+        }
+
+        // With splitRuns set every per-sample stage gets a step of its own, which
+        // is slower but lets each one be timed separately.
+        static FxProgram compile (const FxOrder& order, const std::array<bool, (size_t) numFxStages>& enabled,
+                                  bool splitRuns = false)
+        {
+            FxProgram program;
+
+            bool inRun = true;              // input gain opens the first fused run
+            juce::uint8 runFlags = inputGainFlag;
+            std::array<FxStage, 2> runMiddle {};
+            int runMiddleCount = 0;
+
+            auto flushRun = [&]
+            {
+                if (! inRun)
+                    return;
+
+                auto middle = FusedMiddle::none;
+                if (runMiddleCount == 1)
+                    middle = runMiddle[0] == FxStage::eq ? FusedMiddle::eq : FusedMiddle::shaper;
+                else if (runMiddleCount == 2)
+                    middle = runMiddle[0] == FxStage::eq ? FusedMiddle::eqThenShaper : FusedMiddle::shaperThenEq;
+
+                if (runFlags != 0 || middle != FusedMiddle::none)
+                    program.steps[program.numSteps++] = (juce::uint8) (fusedOp | runFlags | ((juce::uint8) middle << middleShift));
+
+                inRun = false;
+                runFlags = 0;
+                runMiddleCount = 0;
+            };
+
+            if (splitRuns)
+                flushRun();
+
+            for (auto stage : order)
+            {
+                if (! enabled[(size_t) stage])
+                    continue;
+
+                if (stage == FxStage::eq || stage == FxStage::shaper)
+                {
+                    inRun = true;
+                    runMiddle[(size_t) runMiddleCount++] = stage;
+
+                    if (splitRuns)
+                        flushRun();
+
+                    continue;
+                }
+
+                flushRun();
+
+                switch (stage)
+                {
+                    case FxStage::dynamics: program.steps[program.numSteps++] = dynamicsOp; break;
+                    case FxStage::chorus:   program.steps[program.numSteps++] = chorusOp; break;
+                    case FxStage::delay:    program.steps[program.numSteps++] = delayOp; break;
+                    case FxStage::reverb:   program.steps[program.numSteps++] = reverbOp; break;
+                    case FxStage::eq:
+                    case FxStage::shaper:
+                        break;
+                }
+            }
+
+            // Output gain closes the last fused run (or opens its own).
+            if (splitRuns)
+                flushRun();
+
+            inRun = true;
+            runFlags |= outputGainFlag;
+            flushRun();
+
+            return program;
+        }
+    };
+
+    //==============================================================================
+    // Owns the stage order and keeps a compiled FxProgram in step with it and with
+    // the stage bypass parameters. The FX thread asks for the program once per
+    // block and it is recompiled there and then if the order, a bypass parameter
+    // or the split flag has moved since the last block, so bypass automation
+    // lands on the block it was written for, in realtime or offline. Compiling is
+    // allocation-free; an unchanged block costs six parameter loads.
+    class FxChain
+    {
+    public:
+        explicit FxChain (juce::AudioProcessorValueTreeState& stateIn)
+        {
+            storeOrder (getDefaultFxOrder());
+
+            for (int s = 0; s < numFxStages; ++s)
+                enableParameters[(size_t) s] = stateIn.getRawParameterValue (getFxStageEnableParameter ((FxStage) s));
+        }
+
+        // Any thread. Takes effect from the next block.
+        void setOrder (const FxOrder& order) noexcept
+        {
+            storeOrder (order);
+        }
+
+        FxOrder getOrder() const noexcept
+        {
+            return unpackOrder (packedOrder.load());
+        }
+
+        // Any thread. Used while profiling so each per-sample stage can be timed
+        // on its own.
+        void setSplitRuns (bool shouldSplit) noexcept
+        {
+            splitRuns.store (shouldSplit);
+        }
+
+        // FX thread, once per block.
+        FxProgram getProgram() noexcept
+        {
+            const auto order = packedOrder.load();
+            const auto enabled = readEnabledStages();
+            const auto split = splitRuns.load();
+
+            juce::uint32 key = order | (split ? 1u << 30 : 0u);
+            for (int s = 0; s < numFxStages; ++s)
+                key |= enabled[(size_t) s] ? 1u << (24 + s) : 0u;
+
+            if (key != compiledKey)
+            {
+                compiledKey = key;
+                program = FxProgram::compile (unpackOrder (order), enabled, split);
+            }
+
+            return program;
+        }
+
+    private:
+        void storeOrder (const FxOrder& order) noexcept
+        {
+            juce::uint32 packed = 0;
+            for (int i = 0; i < numFxStages; ++i)
+                packed |= (juce::uint32) order[(size_t) i] << (i * 4);
+            packedOrder.store (packed);
+        }
+
+        static FxOrder unpackOrder (juce::uint32 packed) noexcept
+        {
+            FxOrder order {};
+            for (int i = 0; i < numFxStages; ++i)
+                order[(size_t) i] = (FxStage) ((packed >> (i * 4)) & 0x0f);
+            return order;
+        }
+
+        std::array<bool, (size_t) numFxStages> readEnabledStages() const noexcept
+        {
+            std::array<bool, (size_t) numFxStages> enabled {};
+            for (int s = 0; s < numFxStages; ++s)
+                if (auto* p = enableParameters[(size_t) s])
+                    enabled[(size_t) s] = p->load() > 0.5f;
+            return enabled;
+        }
+
+        std::array<std::atomic<float>*, (size_t) numFxStages> enableParameters {};
+        std::atomic<juce::uint32> packedOrder { 0 };
+        std::atomic<bool> splitRuns { false };
+
+        // FX thread only: the inputs the program was compiled from (order, bypass
+        // bits, split flag), and the program itself.
+        juce::uint32 compiledKey = ~0u;
+        FxProgram program;
+
+        JUCE_DECLARE_NON_COPYABLE (FxChain)
+    };
+} // namespace soulbass
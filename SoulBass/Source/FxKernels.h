@@ -0,0 +1,179 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace soulbass
+{
+    //==============================================================================
+    // Low shelf / peak / high shelf, one biquad set per channel. Kept as plain
+    // filters (rather than ProcessorDuplicator) so the fused kernels can run them
+    // one sample at a time alongside the gain and shaper.
+    class ThreeBandEq
+    {
+    public:
+        using Coefficients = juce::dsp::IIR::Coefficients<float>;
+
+        ThreeBandEq()
+        {
+            for (auto& c : bandCoefficients)
+                c = new Coefficients (1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
+
+            for (auto& channel : filters)
+                for (size_t band = 0; band < numBands; ++band)
+                    channel[band].coefficients = bandCoefficients[band];
+        }
+
+        void prepare (const juce::dsp::ProcessSpec& spec)
+        {
+            const juce::dsp::ProcessSpec mono { spec.sampleRate, spec.maximumBlockSize, 1 };
+            for (auto& channel : filters)
+                for (auto& f : channel)
+                    f.prepare (mono);
+        }
+
+        void reset()
+        {
+            for (auto& channel : filters)
+                for (auto& f : channel)
+                    f.reset();
+        }
+
+        // Band 0 is the low shelf, 1 the peak, 2 the high shelf.
+        void setBandCoefficients (size_t band, const Coefficients& newCoefficients)
+        {
+            *bandCoefficients[band] = newCoefficients;
+        }
+
+        float processSample (int channel, float x) noexcept
+        {
+            auto& f = filters[(size_t) channel];
+            return f[2].processSample (f[1].processSample (f[0].processSample (x)));
+        }
+
+        void snapToZero() noexcept
+        {
+            for (auto& channel : filters)
+                for (auto& f : channel)
+                    f.snapToZero();
+        }
+
+    private:
+        static constexpr size_t numBands = 3;
+
+        std::array<Coefficients::Ptr, numBands> bandCoefficients;
+        std::array<std::array<juce::dsp::IIR::Filter<float>, numBands>, 2> filters;
+    };
+
+    //==============================================================================
+    struct Shaper
+    {
+        float drive = 1.0f;
+        float bias = 0.0f;
+        int type = 0;
+
+        float processSample (float x) const noexcept
+        {
+            const float biased = (x + bias) * drive;
+            switch (type)
+            {
+                case 1: // Tube-ish
+                    return juce::jlimit (-1.2f, 1.2f, std::tanh (biased) * 0.8f);
+                case 2: // Tape-ish soft clip
+                {
+                    const float s = juce::jlimit (-2.5f, 2.5f, biased);
+                    return s - (s * s * s) * 0.08f;
+                }
+                default: // Soft clip
+                    return juce::jlimit (-1.0f, 1.0f, biased / (1.0f + std::abs (biased)));
+            }
+        }
+    };
+
+    //==============================================================================
+    // Per-sample stages that can share one pass over the buffer. Input gain always
+    // leads and output gain always trails, so a fused run is fully described by
+    // which gains it carries and how EQ and shaper are arranged in between.
+    enum class FusedMiddle : juce::uint8
+    {
+        none = 0,
+        eq,
+        shaper,
+        eqThenShaper,
+        shaperThenEq
+    };
+
+    struct FusedStageContext
+    {
+        float* const* channels;
+        int numChannels;
+        int numSamples;
+        const float* inputGain;
+        const float* outputGain;
+        ThreeBandEq& eq;
+        const Shaper& shaper;
+    };
+
+    template <bool applyInputGain, bool applyOutputGain, FusedMiddle middle>
+    void runFusedStage (const FusedStageContext& c) noexcept
+    {
+        for (int ch = 0; ch < c.numChannels; ++ch)
+        {
+            auto* data = c.channels[ch];
+
+            for (int i = 0; i < c.numSamples; ++i)
+            {
+                auto x = data[i];
+
+                if constexpr (applyInputGain)
+                    x *= c.inputGain[i];
+
+                if constexpr (middle == FusedMiddle::eq || middle == FusedMiddle::eqThenShaper)
+                    x = c.eq.processSample (ch, x);
+
+                if constexpr (middle == FusedMiddle::shaper || middle == FusedMiddle::eqThenShaper
+                              || middle == FusedMiddle::shaperThenEq)
+                    x = c.shaper.processSample (x);
+
+                if constexpr (middle == FusedMiddle::shaperThenEq)
+                    x = c.eq.processSample (ch, x);
+
+                if constexpr (applyOutputGain)
+                    x *= c.outputGain[i];
+
+                data[i] = x;
+            }
+        }
+    }
+
+    namespace detail
+    {
+        template <FusedMiddle middle>
+        void runFusedStageWithGains (bool inputGain, bool outputGain, const FusedStageContext& c) noexcept
+        {
+            if (inputGain)
+            {
+                if (outputGain) runFusedStage<true, true, middle> (c);
+                else            runFusedStage<true, false, middle> (c);
+            }
+            else
+            {
+                if (outputGain) runFusedStage<false, true, middle> (c);
+                else            runFusedStage<false, false, middle> (c);
+            }
+        }
+    } // namespace detail
+
+    // Picks the pre-instantiated kernel once per block.
+    inline void runFusedStage (FusedMiddle middle, bool inputGain, bool outputGain, const FusedStageContext& c) noexcept
+    {
+        switch (middle)
+        {
+            case FusedMiddle::eq:           detail::runFusedStageWithGains<FusedMiddle::eq> (inputGain, outputGain, c); break;
+            case FusedMiddle::shaper:       detail::runFusedStageWithGains<FusedMiddle::shaper> (inputGain, outputGain, c); break;
+            case FusedMiddle::eqThenShaper: detail::runFusedStageWithGains<FusedMiddle::eqThenShaper> (inputGain, outputGain, c); break;
+            case FusedMiddle::shaperThenEq: detail::runFusedStageWithGains<FusedMiddle::shaperThenEq> (inputGain, outputGain, c); break;
+            case FusedMiddle::none:
+            default:                        detail::runFusedStageWithGains<FusedMiddle::none> (inputGain, outputGain, c); break;
+        }
+    }
+} // namespace soulbass
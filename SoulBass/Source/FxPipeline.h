@@ -0,0 +1,200 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+namespace soulbass
+{
+    //==============================================================================
+    // Runs the FX chain one block behind voice rendering on its own thread.
+    //
+    // The pipeline is a delay line of latencySamples frames with the FX applied on
+    // the way through. Each call to process() waits for the previous job, swaps the
+    // incoming (dry) block for the oldest processed frames and hands the dry block
+    // to the worker, which writes its processed result back into the slots that
+    // were just read. The host thread can then render the next block of voices
+    // while the worker runs the FX on this one.
+    //
+    // The hand-off is a single atomic flag: the audio thread never locks or
+    // allocates, and the worker only ever touches the ring between a submit and
+    // the matching completion.
+    //
+    // The worker thread only exists while the pipeline is in use. The audio thread
+    // asks for it on the first pipelined block and the message thread starts it;
+    // until then the FX run in line.
+    class FxPipeline : private juce::AsyncUpdater
+    {
+    public:
+        using ProcessFunction = std::function<void (juce::AudioBuffer<float>&)>;
+
+        FxPipeline() : worker (*this) {}
+
+        ~FxPipeline() override
+        {
+            cancelPendingUpdate();
+            worker.stopThread (2000);
+        }
+
+        // Message thread. latencySamples is normally the host's maximum block size.
+        void prepare (int numChannelsIn, int latencySamples, ProcessFunction processIn)
+        {
+            waitUntilIdle();
+
+            numChannels = juce::jmax (1, numChannelsIn);
+            latency = juce::jmax (1, latencySamples);
+            processFunction = std::move (processIn);
+
+            ring.setSize (numChannels, latency);
+            job.setSize (numChannels, latency);
+            reset();
+        }
+
+        // Message thread. Starts the worker if it isn't running yet.
+        void start()
+        {
+            cancelPendingUpdate();
+
+            if (running.load())
+                return;
+
+            if (! worker.startRealtimeThread (juce::Thread::RealtimeOptions()))
+                worker.startThread (juce::Thread::Priority::highest);
+
+            running.store (true, std::memory_order_release);
+        }
+
+        // Audio thread. Has the message thread start the worker; isRunning() stays
+        // false until it has.
+        void requestStart() noexcept
+        {
+            if (! running.load (std::memory_order_acquire))
+                triggerAsyncUpdate();
+        }
+
+        bool isRunning() const noexcept { return running.load (std::memory_order_acquire); }
+
+        // Message thread, while no audio is being processed. Stops the worker.
+        void stop()
+        {
+            cancelPendingUpdate();
+            waitUntilIdle();
+            running.store (false, std::memory_order_release);
+            worker.stopThread (2000);
+        }
+
+        // Silences the line. Not while a job is running.
+        void reset() noexcept
+        {
+            ring.clear();
+            readPosition = 0;
+        }
+
+        int getLatencySamples() const noexcept { return latency; }
+
+        // Audio thread. Replaces the buffer with processed audio from
+        // latencySamples ago and queues its current contents for the FX.
+        void process (juce::AudioBuffer<float>& buffer) noexcept
+        {
+            const auto channels = juce::jmin (numChannels, buffer.getNumChannels());
+
+            // Blocks longer than the line go through in line-sized pieces.
+            for (int offset = 0; offset < buffer.getNumSamples(); offset += latency)
+            {
+                const auto num = juce::jmin (latency, buffer.getNumSamples() - offset);
+                waitUntilIdle();
+
+                for (int ch = 0; ch < channels; ++ch)
+                    job.copyFrom (ch, 0, buffer, ch, offset, num);
+
+                const auto first = juce::jmin (num, latency - readPosition);
+                for (int ch = 0; ch < channels; ++ch)
+                {
+                    buffer.copyFrom (ch, offset, ring, ch, readPosition, first);
+                    if (num > first)
+                        buffer.copyFrom (ch, offset + first, ring, ch, 0, num - first);
+                }
+
+                jobStart = readPosition;
+                jobSamples = num;
+                readPosition = (readPosition + num) % latency;
+
+                busy.store (true, std::memory_order_release);
+                worker.notify();
+            }
+        }
+
+        // Blocks (spinning) until the worker has finished its current job, after
+        // which the FX state may be touched from the calling thread again.
+        void waitUntilIdle() const noexcept
+        {
+            while (busy.load (std::memory_order_acquire))
+            {
+               #if JUCE_INTEL
+                _mm_pause();
+               #else
+                std::this_thread::yield();
+               #endif
+            }
+        }
+
+    private:
+        void handleAsyncUpdate() override { start(); }
+
+        void runJob()
+        {
+            juce::AudioBuffer<float> view (job.getArrayOfWritePointers(), numChannels, jobSamples);
+            processFunction (view);
+
+            const auto first = juce::jmin (jobSamples, latency - jobStart);
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                ring.copyFrom (ch, jobStart, view, ch, 0, first);
+                if (jobSamples > first)
+                    ring.copyFrom (ch, 0, view, ch, first, jobSamples - first);
+            }
+
+            busy.store (false, std::memory_order_release);
+        }
+
+        class Worker : public juce::Thread
+        {
+        public:
+            explicit Worker (FxPipeline& ownerIn)
+                : juce::Thread ("SoulBass FX Pipeline"), owner (ownerIn)
+            {
+            }
+
+            void run() override
+            {
+                while (! threadShouldExit())
+                {
+                    wait (-1);
+
+                    if (owner.busy.load (std::memory_order_acquire))
+                        owner.runJob();
+                }
+            }
+
+        private:
+            FxPipeline& owner;
+        };
+
+        //==============================================================================
+        int numChannels = 2;
+        int latency = 512;
+        ProcessFunction processFunction;
+
+        juce::AudioBuffer<float> ring, job;
+        int readPosition = 0;
+        int jobStart = 0, jobSamples = 0;
+
+        std::atomic<bool> busy { false };
+        std::atomic<bool> running { false };
+        Worker worker;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FxPipeline)
+    };
+} // namespace soulbass
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace soulbass
+{
+    //==============================================================================
+    // Rungs of the quality ladder, in the order they are given up: the ones that
+    // are hardest to hear go first.
+    enum class QualityStep
+    {
+        controlRate = 0,    // LFO and cutoff modulation every 16 samples
+        reverbLines,        // algorithmic reverb instead of convolution, two chorus lines
+        filterModel,        // the ladder filter runs as the SVF low-pass, from the next note
+        unisonLanes,        // unison stacks capped at two lanes, from the next note
+        voiceLimit          // polyphony halved, surplus voices released
+    };
+
+    constexpr int numQualitySteps = 5;
+
+    inline const char* getQualityStepName (QualityStep step)
+    {
+        switch (step)
+        {
+            case QualityStep::controlRate:   return "control rate";
+            case QualityStep::reverbLines:   return "reverb lines";
+            case QualityStep::filterModel:   return "filter model";
+            case QualityStep::unisonLanes:   return "unison lanes";
+            case QualityStep::voiceLimit:    return "voice limit";
+        }
+
+        return "";
+    }
+
+    //==============================================================================
+    // Trades fidelity for headroom when processBlock runs close to its deadline.
+    //
+    // The audio thread reports the wall-clock cost of each block. While the load
+    // stays above stepDownLoad for stepDownSeconds, one more rung of the ladder is
+    // given up; once it has stayed below stepUpLoad for stepUpSeconds, the last
+    // rung is taken back. Stepping up is deliberately slower than stepping down so
+    // the governor doesn't oscillate around the threshold. Rungs that would change
+    // nothing in the current setup are skipped in both directions.
+    //
+    // Steps are queued for the message thread, which writes them to the Logger;
+    // the audio thread never formats or locks.
+    class LoadGovernor : private juce::Timer
+    {
+    public:
+        static constexpr double stepDownLoad = 0.8;
+        static constexpr double stepUpLoad = 0.5;
+        static constexpr double stepDownSeconds = 0.05;
+        static constexpr double stepUpSeconds = 2.0;
+
+        struct Step
+        {
+            int level;          // rungs given up after this step
+            QualityStep rung;   // the rung that changed
+            bool down;
+            float load;         // smoothed load that triggered it
+        };
+
+        LoadGovernor()
+        {
+            startTimer (250);
+        }
+
+        ~LoadGovernor() override
+        {
+            stopTimer();
+        }
+
+        // Audio thread. A disabled governor gives every rung back at once.
+        void setEnabled (bool shouldBeEnabled) noexcept
+        {
+            if (shouldBeEnabled == enabled)
+                return;
+
+            enabled = shouldBeEnabled;
+            overSeconds = underSeconds = 0.0;
+            smoothedLoad = 0.0;
+
+            while (! enabled && level > 0)
+                stepUp (level - 1);
+        }
+
+        bool isEnabled() const noexcept { return enabled; }
+
+        // Audio thread, once per block before rendering. available has bit n set if
+        // QualityStep n would save anything right now.
+        void setAvailableSteps (juce::uint32 mask) noexcept { available = mask; }
+
+        // Audio thread, after the block. seconds is the time processBlock took.
+        void addBlock (double seconds, int numSamples, double sampleRate) noexcept
+        {
+            if (! enabled || numSamples <= 0 || sampleRate <= 0.0)
+                return;
+
+            const auto blockSeconds = numSamples / sampleRate;
+            const auto load = seconds / blockSeconds;
+
+            // Fast to rise, slow to fall: one bad block counts, one good one doesn't.
+            smoothedLoad = load > smoothedLoad ? load : smoothedLoad + 0.1 * (load - smoothedLoad);
+
+            overSeconds = smoothedLoad > stepDownLoad ? overSeconds + blockSeconds : 0.0;
+            underSeconds = smoothedLoad < stepUpLoad ? underSeconds + blockSeconds : 0.0;
+
+            if (overSeconds >= stepDownSeconds)
+            {
+                overSeconds = 0.0;
+
+                for (int rung = level; rung < numQualitySteps; ++rung)
+                {
+                    if (isAvailable (rung))
+                    {
+                        stepDown (rung);
+                        break;
+                    }
+                }
+            }
+            else if (underSeconds >= stepUpSeconds && level > 0)
+            {
+                underSeconds = 0.0;
+                stepUp (level - 1);
+            }
+        }
+
+        // Any thread (the FX may run on the pipeline thread). Whether the given rung
+        // has been given up.
+        bool isDegraded (QualityStep step) const noexcept
+        {
+            return ((degraded.load (std::memory_order_relaxed) >> (int) step) & 1u) != 0;
+        }
+
+        // Number of rungs given up, for display.
+        int getLevel() const noexcept { return publishedLevel.load (std::memory_order_relaxed); }
+
+    private:
+        static constexpr int logSize = 64;
+
+        bool isAvailable (int rung) const noexcept { return ((available >> rung) & 1u) != 0; }
+
+        void stepDown (int rung) noexcept
+        {
+            degraded.fetch_or (1u << rung, std::memory_order_relaxed);
+            level = rung + 1;
+            publish ((QualityStep) rung, true);
+        }
+
+        // Restores the last rung given up, and any skipped ones below it.
+        void stepUp (int rung) noexcept
+        {
+            degraded.fetch_and (~(1u << rung), std::memory_order_relaxed);
+            level = rung;
+
+            while (level > 0 && ! isDegraded ((QualityStep) (level - 1)))
+                --level;
+
+            publish ((QualityStep) rung, false);
+        }
+
+        void publish (QualityStep rung, bool down) noexcept
+        {
+            publishedLevel.store (level, std::memory_order_relaxed);
+
+            const auto scope = fifo.write (1);
+            if (scope.blockSize1 > 0)
+                log[(size_t) scope.startIndex1] = { level, rung, down, (float) smoothedLoad };
+        }
+
+        void timerCallback() override
+        {
+            const auto scope = fifo.read (fifo.getNumReady());
+
+            auto write = [this] (int start, int size)
+            {
+                for (int i = start; i < start + size; ++i)
+                {
+                    const auto& s = log[(size_t) i];
+                    juce::Logger::writeToLog (juce::String ("SoulBass governor: ") + (s.down ? "reduced " : "restored ")
+                                              + getQualityStepName (s.rung) + " at "
+                                              + juce::String (s.load * 100.0f, 0) + "% load (level "
+                                              + juce::String (s.level) + ")");
+                }
+            };
+
+            write (scope.startIndex1, scope.blockSize1);
+            write (scope.startIndex2, scope.blockSize2);
+        }
+
+        bool enabled = false;
+        juce::uint32 available = 0;
+        std::atomic<juce::uint32> degraded { 0 };
+        int level = 0;
+        double smoothedLoad = 0.0, overSeconds = 0.0, underSeconds = 0.0;
+        std::atomic<int> publishedLevel { 0 };
+
+        juce::AbstractFifo fifo { logSize };
+        std::array<Step, (size_t) logSize> log {};
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadGovernor)
+    };
+} // namespace soulbass
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace soulbass
+{
+    //==============================================================================
+    // Thins continuous controller and pitch-bend streams before they reach the
+    // synth.
+    //
+    // juce::Synthesiser splits its render at every MIDI event, so a sweeping mod
+    // wheel or bend can chop a block into dozens of tiny sub-blocks. Here every
+    // (channel, controller) stream keeps only its last value in each window of
+    // `resolution` samples, moved to the start of that window. However chatty the
+    // controller, it can then split a block at most numSamples / resolution times,
+    // and the voices ramp between the values that remain. Notes, switch
+    // controllers (sustain and friends) and mode messages pass through untouched
+    // and sample-accurate.
+    class MidiCoalescer
+    {
+    public:
+        // Message thread. Reserves room for a block's worth of events.
+        void prepare (int maxBytesPerBlock)
+        {
+            output.ensureSize ((size_t) maxBytesPerBlock);
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            pending.fill ({});
+            numTouched = 0;
+        }
+
+        // 0 or 1 passes everything through.
+        void setResolution (int numSamples) noexcept { resolution = juce::jmax (1, numSamples); }
+        int getResolution() const noexcept { return resolution; }
+
+        // Audio thread. The result stays valid until the next call.
+        const juce::MidiBuffer& process (const juce::MidiBuffer& input) noexcept
+        {
+            output.clear();
+
+            if (resolution <= 1)
+            {
+                output.addEvents (input, 0, -1, 0);
+                return output;
+            }
+
+            for (const auto metadata : input)
+            {
+                const auto key = getStreamKey (metadata.data, metadata.numBytes);
+
+                if (key < 0)
+                {
+                    output.addEvent (metadata.data, metadata.numBytes, metadata.samplePosition);
+                    continue;
+                }
+
+                auto& stream = pending[(size_t) key];
+                const auto window = metadata.samplePosition / resolution;
+
+                if (stream.window < 0)
+                    touched[(size_t) numTouched++] = (juce::uint16) key;
+                else if (stream.window != window)
+                    flush (stream);
+
+                stream.window = window;
+                std::copy (metadata.data, metadata.data + 3, stream.bytes.begin());
+            }
+
+            for (int i = 0; i < numTouched; ++i)
+                flush (pending[(size_t) touched[(size_t) i]]);
+
+            numTouched = 0;
+            return output;
+        }
+
+    private:
+        static constexpr int numStreams = 16 * 129;    // 128 controllers and the wheel per channel
+
+        struct Stream
+        {
+            int window = -1;
+            std::array<juce::uint8, 3> bytes {};
+        };
+
+        // Index of the stream a message belongs to, or -1 if it mustn't be thinned.
+        static int getStreamKey (const juce::uint8* data, int numBytes) noexcept
+        {
+            if (numBytes != 3)
+                return -1;
+
+            const auto channel = data[0] & 0x0f;
+
+            switch (data[0] & 0xf0)
+            {
+                case 0xe0:
+                    return channel * 129 + 128;
+
+                case 0xb0:
+                {
+                    // Sustain, portamento, sostenuto, soft, legato and hold 2, and
+                    // channel mode messages, are switches: every edge matters.
+                    const auto controller = data[1];
+                    if ((controller >= 64 && controller <= 69) || controller >= 120)
+                        return -1;
+
+                    // So are the data entry / (N)RPN selectors, whose order matters.
+                    if (controller == 6 || controller == 38 || (controller >= 96 && controller <= 101))
+                        return -1;
+
+                    return channel * 129 + controller;
+                }
+
+                default:
+                    return -1;
+            }
+        }
+
+        void flush (Stream& stream) noexcept
+        {
+            output.addEvent (stream.bytes.data(), 3, stream.window * resolution);
+            stream.window = -1;
+        }
+
+        int resolution = 1;
+        juce::MidiBuffer output;
+
+        std::array<Stream, (size_t) numStreams> pending;
+        std::array<juce::uint16, (size_t) numStreams> touched {};
+        int numTouched = 0;
+
+        JUCE_DECLARE_NON_COPYABLE (MidiCoalescer)
+    };
+} // namespace soulbass
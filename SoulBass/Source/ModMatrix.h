@@ -0,0 +1,186 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace soulbass
+{
+    //==============================================================================
+    enum class ModSource
+    {
+        lfo = 0,        // the voice LFO, -1..1, before depth and mod wheel
+        envelope,       // the voice's amp envelope, 0..1
+        velocity,       // 0..1
+        modWheel,       // 0..1
+        aftertouch,     // channel or key pressure, 0..1
+        pitchBend       // -1..1
+    };
+
+    constexpr int numModSources = 6;
+    using ModSourceValues = std::array<float, (size_t) numModSources>;
+
+    // Per-voice destinations first, then the FX ones, which follow the mean over
+    // the sounding voices.
+    enum class ModDestination
+    {
+        cutoff = 0,     // +-4 octaves
+        resonance,      // +-1.9
+        pitch,          // +-12 semitones
+        amp,            // gain 0..2
+        pan,            // hard left to hard right
+        shaperDrive,    // +-24 dB
+        chorusBlend,    // +-1
+        reverbBlend     // +-1
+    };
+
+    constexpr int numModDestinations = 8;
+    constexpr int numVoiceModDestinations = 5;
+    constexpr int numModSlots = 8;
+
+    inline juce::StringArray getModSourceNames()
+    {
+        return { "LFO", "Envelope", "Velocity", "Mod Wheel", "Aftertouch", "Pitch Bend" };
+    }
+
+    inline juce::StringArray getModDestinationNames()
+    {
+        return { "Cutoff", "Resonance", "Pitch", "Amp", "Pan", "Shaper Drive", "Chorus Blend", "Reverb Blend" };
+    }
+
+    // What the matrix asks of one voice, already scaled to the voice's units.
+    struct VoiceModulation
+    {
+        float cutoffFactor = 1.0f;
+        float resonanceOffset = 0.0f;
+        float pitchSemitones = 0.0f;
+        float ampGain = 1.0f;
+        float pan = 0.0f;
+    };
+
+    //==============================================================================
+    // Routes modulation sources to destinations once per block.
+    //
+    // The slots are folded into a dense destination-by-source matrix, and the
+    // sources of every sounding voice sit in per-source rows, voice by voice. The
+    // routing is then one multiply-add of a source row into a destination row per
+    // non-zero matrix entry, run with FloatVectorOperations across all voices at
+    // once. Empty slots put nothing in the matrix, so they cost nothing, and with
+    // no slot in use the processor skips the matrix entirely.
+    class ModMatrix
+    {
+    public:
+        static constexpr int maxVoices = 16;
+
+        struct Slot
+        {
+            int source = -1;        // ModSource, or -1 for an empty slot
+            int destination = 0;    // ModDestination
+            float amount = 0.0f;    // -1..1
+        };
+
+        // Audio thread, once per block before the sources are set.
+        void setSlots (const std::array<Slot, (size_t) numModSlots>& slots) noexcept
+        {
+            for (auto& row : matrix)
+                row.fill (0.0f);
+
+            usedDestinations = 0;
+
+            for (const auto& slot : slots)
+            {
+                if (slot.source < 0 || slot.source >= numModSources || slot.amount == 0.0f
+                    || slot.destination < 0 || slot.destination >= numModDestinations)
+                    continue;
+
+                matrix[(size_t) slot.destination][(size_t) slot.source] += slot.amount;
+                usedDestinations |= 1u << slot.destination;
+            }
+        }
+
+        bool isActive() const noexcept { return usedDestinations != 0; }
+
+        // Rows in use this block; the voice gathering the sources decides.
+        void setNumVoices (int numVoicesIn) noexcept { numVoices = juce::jlimit (0, maxVoices, numVoicesIn); }
+        int getNumVoices() const noexcept { return numVoices; }
+
+        void setSource (int voice, ModSource source, float value) noexcept
+        {
+            sources[(size_t) source][(size_t) voice] = value;
+        }
+
+        void setSources (int voice, const ModSourceValues& values) noexcept
+        {
+            for (int s = 0; s < numModSources; ++s)
+                sources[(size_t) s][(size_t) voice] = values[(size_t) s];
+        }
+
+        void process() noexcept
+        {
+            for (int d = 0; d < numModDestinations; ++d)
+            {
+                auto* dest = destinations[(size_t) d].data();
+                juce::FloatVectorOperations::clear (dest, numVoices);
+
+                if (((usedDestinations >> d) & 1u) == 0)
+                    continue;
+
+                for (int s = 0; s < numModSources; ++s)
+                    if (const auto amount = matrix[(size_t) d][(size_t) s]; amount != 0.0f)
+                        juce::FloatVectorOperations::addWithMultiply (dest, sources[(size_t) s].data(), amount, numVoices);
+            }
+        }
+
+        // Raw sum for one voice and destination, about -1..1.
+        float getDestination (int voice, ModDestination destination) const noexcept
+        {
+            return destinations[(size_t) destination][(size_t) voice];
+        }
+
+        // Mean over the voices, for the FX destinations.
+        float getMeanDestination (ModDestination destination) const noexcept
+        {
+            if (numVoices == 0)
+                return 0.0f;
+
+            const auto& row = destinations[(size_t) destination];
+            return std::accumulate (row.begin(), row.begin() + numVoices, 0.0f) / (float) numVoices;
+        }
+
+        VoiceModulation getVoiceModulation (int voice) const noexcept
+        {
+            return toVoiceModulation ([this, voice] (ModDestination d) { return getDestination (voice, d); });
+        }
+
+        // One voice routed on its own, outside the block: for a note starting
+        // part-way through one, so it has its modulation from the first sample.
+        VoiceModulation getVoiceModulation (const ModSourceValues& values) const noexcept
+        {
+            return toVoiceModulation ([this, &values] (ModDestination d)
+            {
+                float sum = 0.0f;
+                for (int s = 0; s < numModSources; ++s)
+                    sum += matrix[(size_t) d][(size_t) s] * values[(size_t) s];
+                return sum;
+            });
+        }
+
+    private:
+        template <typename Destination>
+        static VoiceModulation toVoiceModulation (Destination destination) noexcept
+        {
+            VoiceModulation mod;
+            mod.cutoffFactor = std::exp2 (4.0f * destination (ModDestination::cutoff));
+            mod.resonanceOffset = 1.9f * destination (ModDestination::resonance);
+            mod.pitchSemitones = 12.0f * destination (ModDestination::pitch);
+            mod.ampGain = juce::jlimit (0.0f, 2.0f, 1.0f + destination (ModDestination::amp));
+            mod.pan = juce::jlimit (-1.0f, 1.0f, destination (ModDestination::pan));
+            return mod;
+        }
+
+        std::array<std::array<float, (size_t) numModSources>, (size_t) numModDestinations> matrix {};
+        juce::uint32 usedDestinations = 0;
+        int numVoices = 0;
+
+        std::array<std::array<float, (size_t) maxVoices>, (size_t) numModSources> sources {};
+        std::array<std::array<float, (size_t) maxVoices>, (size_t) numModDestinations> destinations {};
+    };
+} // namespace soulbass
@@ -75,6 +75,7 @@ SoulBassAudioProcessorEditor::SoulBassAudioProcessorEditor (SoulBassAudioProcess
 
     addAndMakeVisible (*reverbBlendKnob); addAndMakeVisible (*reverbDecayKnob);
     addAndMakeVisible (reverbTypeBox);
+    addAndMakeVisible (reverbEngineBox);
     addAndMakeVisible (reverbPowerBtn);
 
     addAndMakeVisible (legatoToggle);
@@ -94,10 +95,14 @@ SoulBassAudioProcessorEditor::SoulBassAudioProcessorEditor (SoulBassAudioProcess
     // Setup combo boxes
     filterTypeBox.addItem ("CLASSIC LPF", 1);
     filterTypeBox.addItem ("CLASSIC HPF", 2);
+    filterTypeBox.addItem ("CLASSIC BPF", 3);
+    filterTypeBox.addItem ("CLASSIC NOTCH", 4);
+    filterTypeBox.addItem ("LADDER LPF", 5);
     filterTypeBox.setSelectedId (2);
 
     glideDirectionBox.addItem ("UP", 1);
     glideDirectionBox.addItem ("DOWN", 2);
+    glideDirectionBox.addItem ("BOTH", 3);
     glideDirectionBox.setSelectedId (1);
 
     pitchRangeBox.addItem ("2", 1);
@@ -119,6 +124,10 @@ SoulBassAudioProcessorEditor::SoulBassAudioProcessorEditor (SoulBassAudioProcess
     reverbTypeBox.addItem ("PLATE", 3);
     reverbTypeBox.setSelectedId (1);
 
+    reverbEngineBox.addItem ("ALGO", 1);
+    reverbEngineBox.addItem ("CONV", 2);
+    reverbEngineBox.setSelectedId (1);
+
     shaperTypeBox.addItem ("TYPE", 1);
     shaperTypeBox.addItem ("TUBE", 2);
     shaperTypeBox.addItem ("TAPE", 3);
@@ -193,6 +202,7 @@ SoulBassAudioProcessorEditor::SoulBassAudioProcessorEditor (SoulBassAudioProcess
     reverbBlendAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (params, "reverbBlend", *reverbBlendKnob);
     reverbDecayAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (params, "reverbDecay", *reverbDecayKnob);
     reverbTypeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (params, "reverbType", reverbTypeBox);
+    reverbEngineAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (params, "reverbEngine", reverbEngineBox);
 
     legatoAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment> (params, "legato", legatoToggle);
     retriggerAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment> (params, "retrigger", retriggerToggle);
@@ -211,11 +221,17 @@ SoulBassAudioProcessorEditor::SoulBassAudioProcessorEditor (SoulBassAudioProcess
     delayPowerBtn.setToggleState (true, juce::dontSendNotification);
     reverbPowerBtn.setToggleState (true, juce::dontSendNotification);
 
+    addChildComponent (profilerOverlay);
+    setWantsKeyboardFocus (true);
+
     setSize (850, 600);
 }
 
 SoulBassAudioProcessorEditor::~SoulBassAudioProcessorEditor()
 {
+    if (profilerOverlay.isVisible())
+        processor.setProfilingEnabled (false);
+
     setLookAndFeel (nullptr);
 }
 
@@ -329,6 +345,14 @@ void SoulBassAudioProcessorEditor::paint (juce::Graphics& g)
     g.setFont (juce::Font (8.0f, juce::Font::bold));
     g.drawText ("INPUT", 755, 518, 35, 10, juce::Justification::centred);
     g.drawText ("OUTPUT", 800, 518, 45, 10, juce::Justification::centred);
+
+    // Trace recording indicator (Cmd/Ctrl+Shift+T)
+    if (processor.getTraceRecorder().isRecording())
+    {
+        g.setFont (juce::Font (9.0f, juce::Font::bold));
+        g.setColour (juce::Colour::fromRGB (255, 123, 131));
+        g.drawText ("REC TRACE", 760, 15, 70, 12, juce::Justification::right);
+    }
 }
 
 void SoulBassAudioProcessorEditor::resized()
@@ -418,6 +442,7 @@ void SoulBassAudioProcessorEditor::resized()
     // ==================== REVERB Section ====================
     reverbPowerBtn.setBounds (480, 312, powerSize, powerSize);
     reverbTypeBox.setBounds (325, 340, 95, 22);
+    reverbEngineBox.setBounds (325, 370, 95, 22);
     reverbBlendKnob->setBounds (435, 335, smallKnobSize, smallKnobSize);
     reverbDecayKnob->setBounds (435, 385, smallKnobSize, smallKnobSize);
 
@@ -434,4 +459,47 @@ void SoulBassAudioProcessorEditor::resized()
 
     // ==================== Header Preset Box ====================
     presetBox.setBounds (340, 10, 160, 30);
+
+    profilerOverlay.setBounds (getLocalBounds().reduced (60, 50));
+}
+
+bool SoulBassAudioProcessorEditor::keyPressed (const juce::KeyPress& key)
+{
+    const auto mods = juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier;
+
+    if (key == juce::KeyPress ('p', mods, 0))
+    {
+        const bool show = ! profilerOverlay.isVisible();
+        processor.setProfilingEnabled (show);
+        profilerOverlay.setShowing (show);
+        return true;
+    }
+
+    if (profilerOverlay.isVisible() && key == juce::KeyPress ('s', mods, 0))
+    {
+        profilerOverlay.dumpReport();
+        return true;
+    }
+
+    if (key == juce::KeyPress ('t', mods, 0))
+    {
+        auto& trace = processor.getTraceRecorder();
+
+        if (trace.isRecording())
+        {
+            trace.stop();
+        }
+        else
+        {
+            const auto name = "trace-" + juce::Time::getCurrentTime().formatted ("%Y%m%d-%H%M%S") + ".json";
+            trace.start (juce::File::getSpecialLocation (juce::File::userDocumentsDirectory)
+                             .getChildFile ("SoulBass Traces")
+                             .getChildFile (name));
+        }
+
+        repaint();
+        return true;
+    }
+
+    return false;
 }
@@ -4,6 +4,7 @@
 #include "PluginProcessor.h"
 #include "SoulLookAndFeel.h"
 #include "ImageAssetVerifier.h"
+#include "ProfilerOverlay.h"
 
 class SoulBassAudioProcessorEditor : public juce::AudioProcessorEditor
 {
@@ -13,6 +14,7 @@ public:
 
     void paint (juce::Graphics&) override;
     void resized() override;
+    bool keyPressed (const juce::KeyPress&) override;
 
 private:
     SoulBassAudioProcessor& processor;
@@ -64,6 +66,7 @@ private:
     // Reverb Section
     std::unique_ptr<soulbass::FilmstripKnob> reverbBlendKnob, reverbDecayKnob;
     juce::ComboBox reverbTypeBox;
+    juce::ComboBox reverbEngineBox;
     soulbass::PowerButton reverbPowerBtn;
 
     // Legato Section
@@ -85,6 +88,9 @@ private:
     // Header
     juce::ComboBox presetBox;
 
+    // Developer overlay (hidden until toggled from the keyboard)
+    soulbass::ProfilerOverlay profilerOverlay { processor.getProfiler() };
+
     // Parameter attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> attackAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> decayAttachment;
@@ -122,6 +128,7 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> reverbPowerAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> reverbBlendAttachment, reverbDecayAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> reverbTypeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> reverbEngineAttachment;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> legatoAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> retriggerAttachment;
@@ -3,96 +3,188 @@
 
 namespace
 {
-    const std::vector<const char*> kSampleNames
-    {
-        "01-Jazz Bass 1.wav",
-        "02-Jazz Bass 2.wav",
-        "03-PJ Bass Thump.wav",
-        "04-PJ Lofi.wav",
-        "05-PJ Tape.wav",
-        "06-Mg Sub1.wav",
-        "07-Mg Sub2.wav",
-        "08-Mg Sub3.wav",
-        "09-Mg 2Tri.wav",
-        "10-Mg 3TriSaw.wav",
-        "11-Mg Sync1.wav",
-        "12-Mg Sync2.wav",
-        "13-Mg PWM.wav",
-        "13-Mg Saw Pluck.wav",
-        "14-Mg Square Pluck.wav",
-        "15-Art Fat Analog.wav",
-        "16-Art Fauxlectric.wav",
-        "17-Art Square Up.wav",
-        "18-Art Dirty Bit.wav",
-        "19-Art Slappy.wav",
-        "20-Art Vowel.wav",
-        "21-Prof Funkshun.wav",
-        "22-Prof Shimmy.wav",
-        "23-Prof Rollin.wav",
-        "24-Prof Brass Attack.wav",
-        "25-Prof Buzz off.wav",
-        "26-Prof Buzz Vibes.wav",
-        "27-Prof Substitute.wav",
-        "28-Prof Eightieswav.wav",
-        "29-Prof Cruise.wav",
-        "30-Prof SH Bass.wav",
-        "31-Prof REZ.wav",
-        "32-Prof Big Saw.wav",
-        "33-Prof Soundtrack.wav",
-        "34-Prof Ripper.wav",
-        "35-808 Rattle.wav",
-        "36-808 Roll.wav",
-        "37-808 Shake.wav",
-        "38-808 Rick.wav",
-        "39-Reeses.wav",
-        "40-808 Smooth.wav"
+    // The bundled samples, one per key from kStartNote, each with the fundamental
+    // it was recorded at in Hz. Most are C2; the 808s and the two Mg triangle
+    // patches are C1. Measured 0.3 s in, or nominal C2 where the pitch wanders.
+    struct BundledSample
+    {
+        const char* name;
+        double rootHz;
+    };
+
+    const std::vector<BundledSample> kSamples
+    {
+        { "01-Jazz Bass 1.wav",        65.53 },
+        { "02-Jazz Bass 2.wav",        65.43 },
+        { "03-PJ Bass Thump.wav",      65.62 },
+        { "04-PJ Lofi.wav",            65.62 },
+        { "05-PJ Tape.wav",            65.62 },
+        { "06-Mg Sub1.wav",            64.76 },
+        { "07-Mg Sub2.wav",            64.76 },
+        { "08-Mg Sub3.wav",            64.76 },
+        { "09-Mg 2Tri.wav",            32.55 },
+        { "10-Mg 3TriSaw.wav",         32.64 },
+        { "11-Mg Sync1.wav",           64.76 },
+        { "12-Mg Sync2.wav",           64.95 },
+        { "13-Mg PWM.wav",             65.43 },
+        { "13-Mg Saw Pluck.wav",       65.43 },
+        { "14-Mg Square Pluck.wav",    65.24 },
+        { "15-Art Fat Analog.wav",     65.14 },
+        { "16-Art Fauxlectric.wav",    65.33 },
+        { "17-Art Square Up.wav",      64.66 },
+        { "18-Art Dirty Bit.wav",      65.33 },
+        { "19-Art Slappy.wav",         64.76 },
+        { "20-Art Vowel.wav",          65.14 },
+        { "21-Prof Funkshun.wav",      65.62 },
+        { "22-Prof Shimmy.wav",        65.41 },
+        { "23-Prof Rollin.wav",        65.41 },
+        { "24-Prof Brass Attack.wav",  65.33 },
+        { "25-Prof Buzz off.wav",      65.43 },
+        { "26-Prof Buzz Vibes.wav",    65.41 },
+        { "27-Prof Substitute.wav",    65.43 },
+        { "28-Prof Eightieswav.wav",   65.62 },
+        { "29-Prof Cruise.wav",        65.24 },
+        { "30-Prof SH Bass.wav",       65.43 },
+        { "31-Prof REZ.wav",           65.43 },
+        { "32-Prof Big Saw.wav",       65.62 },
+        { "33-Prof Soundtrack.wav",    65.62 },
+        { "34-Prof Ripper.wav",        65.43 },
+        { "35-808 Rattle.wav",         32.86 },
+        { "36-808 Roll.wav",           32.50 },
+        { "37-808 Shake.wav",          32.64 },
+        { "38-808 Rick.wav",           32.69 },
+        { "39-Reeses.wav",             65.41 },
+        { "40-808 Smooth.wav",         32.64 }
     };
 
     constexpr int kStartNote = 36; // map samples from C2 upwards
+    constexpr int kMaxVoices = 16;
     constexpr int kPitchBendRange = 12;
+    constexpr int kMaxSubBlockSize = 64;
+    constexpr float kSilenceFloor = 1.0e-5f;   // -100 dBFS
+
+    bool isSilent (const juce::AudioBuffer<float>& buffer)
+    {
+        return buffer.getMagnitude (0, buffer.getNumSamples()) < kSilenceFloor;
+    }
+
+    soulbass::ProfileStage getProfileStage (juce::uint8 op)
+    {
+        using soulbass::FxProgram;
+
+        if (FxProgram::isFused (op))
+        {
+            if (FxProgram::hasInputGain (op))
+                return soulbass::ProfileStage::inputGain;
+            if (FxProgram::hasOutputGain (op))
+                return soulbass::ProfileStage::outputGain;
+
+            const auto middle = FxProgram::getMiddle (op);
+            return middle == soulbass::FusedMiddle::shaper || middle == soulbass::FusedMiddle::shaperThenEq
+                       ? soulbass::ProfileStage::shaper
+                       : soulbass::ProfileStage::eq;
+        }
+
+        switch (op)
+        {
+            case FxProgram::dynamicsOp: return soulbass::ProfileStage::dynamics;
+            case FxProgram::chorusOp:   return soulbass::ProfileStage::chorus;
+            case FxProgram::delayOp:    return soulbass::ProfileStage::delay;
+            default:                    return soulbass::ProfileStage::reverb;
+        }
+    }
 } // namespace
 
 SoulBassAudioProcessor::SoulBassAudioProcessor()
     : AudioProcessor (BusesProperties().withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
       apvts (*this, nullptr, "PARAMETERS", createParameterLayout())
 {
-    formatManager.registerBasicFormats();
     synth.setNoteStealingEnabled (true);
+    synth.setTrace (&trace);
+
+    for (int i = 0; i < soulbass::numModSlots; ++i)
+    {
+        const auto prefix = "mod" + juce::String (i + 1);
+        modSlotParameters[(size_t) i] = { apvts.getRawParameterValue (prefix + "Source"),
+                                          apvts.getRawParameterValue (prefix + "Destination"),
+                                          apvts.getRawParameterValue (prefix + "Amount") };
+    }
+
+    trace.attachParameters (*this);
     updateVoices();
 }
 
 void SoulBassAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    processSpec = { sampleRate, (juce::uint32) samplesPerBlock, (juce::uint32) getTotalNumOutputChannels() };
-    inputGain.prepare (processSpec);
-    outputGain.prepare (processSpec);
-    inputGain.setRampDurationSeconds (0.02);
-    outputGain.setRampDurationSeconds (0.02);
-
-    eqLow.prepare (processSpec);
-    eqMid.prepare (processSpec);
-    eqHigh.prepare (processSpec);
-    compressor.prepare (processSpec);
+    // Internal sub-blocks can be longer than a tiny host block.
+    const auto maxBlockSize = juce::jmax (samplesPerBlock, kMaxSubBlockSize);
+
+    processSpec = { sampleRate, (juce::uint32) maxBlockSize, (juce::uint32) getTotalNumOutputChannels() };
+    inputGain.reset (sampleRate, 0.02);
+    outputGain.reset (sampleRate, 0.02);
+    inputGainRamp.assign ((size_t) maxBlockSize, 1.0f);
+    outputGainRamp.assign ((size_t) maxBlockSize, 1.0f);
+
+    subBlockOutput.setSize (getTotalNumOutputChannels(), kMaxSubBlockSize);
+    subBlockOutput.clear();
+    subBlockMidi.ensureSize (4096);
+    subBlockMidi.clear();
+    subBlockFill = 0;
+
+    eq.prepare (processSpec);
+    shaperOversampler.initProcessing ((size_t) maxBlockSize);
+    shaperOversamplerPrimed = false;
+    stageSilentSamples.fill (0);
+    fxTailsDecayed = false;
+    dynamics.prepare (processSpec);
     chorus.prepare (processSpec);
     for (auto& d : delayLines)
         d.prepare (processSpec);
     reverb.prepare (processSpec);
+    convolutionReverb.prepare (processSpec);
+    reverbLoad.reset (sampleRate, samplesPerBlock);
+    fxPipeline.prepare (getTotalNumOutputChannels(), samplesPerBlock,
+                        [this] (juce::AudioBuffer<float>& block) { processFx (block, nullptr); });
 
+    // The pipeline thread is started here if "Pipelined FX" is already on, or
+    // else on the first pipelined block.
+    if (apvts.getRawParameterValue ("pipelinedFx")->load() > 0.5f)
+        fxPipeline.start();
+
+    midiCoalescer.prepare (16384);
     synth.setCurrentPlaybackSampleRate (sampleRate);
+    synth.prepareParallelRendering (juce::jlimit (0, juce::SystemStats::getNumCpus() - 1, maxVoiceWorkers.load()),
+                                    kMaxVoices, maxBlockSize);
     updateVoices();
+    synth.setParallelRenderingEnabled (shouldRenderVoicesInParallel());
+    synth.startPendingWorkers();
     updateFxParameters();
     loadSamples();
 }
 
 void SoulBassAudioProcessor::releaseResources()
 {
+    fxPipeline.stop();
+    fxPipeline.reset();
+
     for (auto& d : delayLines)
         d.reset();
     chorus.reset();
     reverb.reset();
-    compressor.reset();
-    inputGain.reset();
-    outputGain.reset();
+    convolutionReverb.reset();
+    dynamics.reset();
+    eq.reset();
+    inputGain.setCurrentAndTargetValue (inputGain.getTargetValue());
+    outputGain.setCurrentAndTargetValue (outputGain.getTargetValue());
+}
+
+// Silences every voice and clears the FX tails, so nothing from before carries on.
+void SoulBassAudioProcessor::reset()
+{
+    synth.allNotesOff (0, false);
+    releaseResources();
+    stageSilentSamples.fill (0);
+    fxTailsDecayed = false;
 }
 
 bool SoulBassAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
@@ -105,149 +197,428 @@ bool SoulBassAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 void SoulBassAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+
+    if (auto* playHead = getPlayHead())
+        if (auto position = playHead->getPosition())
+            if (auto bpm = position->getBpm())
+                hostBpm.store (*bpm);
+
+    // Until the pipeline thread is up, the FX stay in line.
+    const bool wantsPipeline = apvts.getRawParameterValue ("pipelinedFx")->load() > 0.5f;
+    if (wantsPipeline)
+        fxPipeline.requestStart();
+
+    const bool pipelined = wantsPipeline && fxPipeline.isRunning();
+
+    if (pipelined != wasPipelined)
+    {
+        fxPipeline.waitUntilIdle();
+        fxPipeline.reset();
+        wasPipelined = pipelined;
+    }
+
+    const int subBlockSizes[] { 0, 32, 64 };
+    const auto subBlockSize = subBlockSizes[juce::jlimit (0, 2, (int) std::round (apvts.getRawParameterValue ("subBlockSize")->load()))];
+
+    if (subBlockSize != activeSubBlockSize)
+    {
+        subBlockOutput.clear();
+        subBlockMidi.clear();
+        subBlockFill = 0;
+        activeSubBlockSize = subBlockSize;
+    }
+
+    const auto latency = fxLatency.load() + (pipelined ? fxPipeline.getLatencySamples() : 0) + subBlockSize;
+    if (latency != getLatencySamples())
+        setLatencySamples (latency);
+
+    if (subBlockSize == 0)
+    {
+        renderBlock (buffer, midiMessages, pipelined);
+        return;
+    }
+
+    // Fixed sub-blocks: host audio and MIDI are gathered until a whole sub-block
+    // is due, which is then rendered in one go and played out one sub-block
+    // later. However the host slices its buffers, every render sees exactly
+    // subBlockSize frames.
+    const auto numSamples = buffer.getNumSamples();
+    const auto numChannels = juce::jmin (buffer.getNumChannels(), subBlockOutput.getNumChannels());
+
+    for (int position = 0; position < numSamples;)
+    {
+        const auto num = juce::jmin (numSamples - position, subBlockSize - subBlockFill);
+
+        for (auto it = midiMessages.findNextSamplePosition (position); it != midiMessages.end(); ++it)
+        {
+            const auto metadata = *it;
+            if (metadata.samplePosition >= position + num)
+                break;
+
+            subBlockMidi.addEvent (metadata.data, metadata.numBytes, subBlockFill + metadata.samplePosition - position);
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            buffer.copyFrom (ch, position, subBlockOutput, ch, subBlockFill, num);
+
+        subBlockFill += num;
+        position += num;
+
+        if (subBlockFill == subBlockSize)
+        {
+            juce::AudioBuffer<float> view (subBlockOutput.getArrayOfWritePointers(), subBlockOutput.getNumChannels(), subBlockSize);
+            renderBlock (view, subBlockMidi, pipelined);
+            subBlockMidi.clear();
+            subBlockFill = 0;
+        }
+    }
+}
+
+void SoulBassAudioProcessor::renderBlock (juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages, bool pipelined)
+{
+    const auto blockStartTicks = juce::Time::getHighResolutionTicks();
+    soulbass::TraceRecorder::ScopedSpan traceBlock (&trace, soulbass::TraceEventType::blockBegin, 0, buffer.getNumSamples());
     buffer.clear();
 
-    // Track mod wheel for LFO depth.
-    for (const auto metadata : midiMessages)
+    midiCoalescer.setResolution (controllerResolution.load());
+    const auto& midi = midiCoalescer.process (midiMessages);
+
+    // Track mod wheel for LFO depth, and the controllers the mod matrix reads
+    // when no voice is sounding.
+    for (const auto metadata : midi)
     {
         const auto& m = metadata.getMessage();
         if (m.isController() && m.getControllerNumber() == 1)
             currentModWheel = (float) m.getControllerValue() / 127.0f;
+        else if (m.isPitchWheel())
+            currentPitchBend = (float) (m.getPitchWheelValue() - 8192) / 8192.0f;
+        else if (m.isChannelPressure())
+            currentPressure = (float) m.getChannelPressureValue() / 127.0f;
+
+        if (m.isNoteOn() && trace.isRecording() && ! hasSoundForNote (m.getNoteNumber()))
+            trace.record (soulbass::TraceEventType::sampleMiss, 0, m.getNoteNumber());
     }
 
-    updateVoiceParameters();
-    updateFxParameters();
+    if (trace.isRecording())
+    {
+        trace.flushParameterChanges();
+        traceFxBypassChanges();
+    }
+
+    // Offline bounces get the high-quality profile. Everything it needs was
+    // allocated in prepareToPlay, so switching is just flags: the FX program is
+    // recompiled from the split flag on the FX thread's next block.
+    if (isNonRealtime() != highQuality.load())
+    {
+        highQuality.store (isNonRealtime());
+        updateSplitRuns();
+    }
+
+    // Live only: offline renders have no deadline to protect.
+    governor.setEnabled (! isNonRealtime() && apvts.getRawParameterValue ("cpuGovernor")->load() > 0.5f);
+    governor.setAvailableSteps (getAvailableQualitySteps());
+
+    // With nothing sounding and nothing arriving the synth has nothing to do, and
+    // the buffer stays in its cleared state.
+    const bool voicesIdle = midi.isEmpty() && synth.getNumActiveVoices() == 0;
+
+    // Idle, the FX destinations of the matrix still follow the performance
+    // controllers rather than the last voice's sources.
+    if (! voicesIdle)
+        updateVoiceParameters (buffer.getNumSamples());
+    else
+        updateModulation (buffer.getNumSamples());
+
+    soulbass::StageProfiler::BlockTimer timing (profiler, buffer.getNumSamples(), processSpec.sampleRate);
+
+    if (! voicesIdle)
+        synth.renderNextBlock (buffer, midi, 0, buffer.getNumSamples());
+
+    timing.mark (soulbass::ProfileStage::voices);
+
+    // Pipelined, the FX for this block run on the pipeline thread while the next
+    // block's voices render here, and what goes out is the previous block's FX.
+    // Stage timings are only collected for the in-line path.
+    if (pipelined)
+        fxPipeline.process (buffer);
+    else
+        processFx (buffer, &timing);
+
+    governor.addBlock (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - blockStartTicks),
+                       buffer.getNumSamples(), processSpec.sampleRate);
+
+    if (governor.getLevel() != tracedQualityLevel)
+    {
+        tracedQualityLevel = governor.getLevel();
+        if (trace.isRecording())
+            trace.record (soulbass::TraceEventType::qualityStep, 0, tracedQualityLevel);
+    }
+}
+
+void SoulBassAudioProcessor::processFx (juce::AudioBuffer<float>& buffer, soulbass::StageProfiler::BlockTimer* timing)
+{
+    juce::ScopedNoDenormals noDenormals;
 
-    synth.renderNextBlock (buffer, midiMessages, 0, buffer.getNumSamples());
+    // Silent in and every tail decayed: the block goes out as it came, without
+    // even a parameter update.
+    bool silent = isSilent (buffer);
+    if (silent && fxTailsDecayed)
+        return;
 
-    auto* inGain = apvts.getRawParameterValue ("inputGain");
-    auto* outGain = apvts.getRawParameterValue ("outputGain");
+    oversampleShaper = highQuality.load();
+    updateFxParameters();
 
-    inputGain.setGainDecibels (*inGain);
-    outputGain.setGainDecibels (*outGain);
+    if (! oversampleShaper)
+        shaperOversamplerPrimed = false;
+
+    inputGain.setTargetValue (juce::Decibels::decibelsToGain (apvts.getRawParameterValue ("inputGain")->load()));
+    outputGain.setTargetValue (juce::Decibels::decibelsToGain (apvts.getRawParameterValue ("outputGain")->load()));
 
     juce::dsp::AudioBlock<float> block (buffer);
     auto context = juce::dsp::ProcessContextReplacing<float> (block);
 
-    inputGain.process (context);
+    const auto numSamples = buffer.getNumSamples();
+    bool allDecayed = true;
+
+    // Bypassed stages are not in the program at all, and the per-sample stages
+    // (gains, EQ, shaper) arrive pre-merged into single passes. A stage whose
+    // input and output have both stayed under the floor for longer than its tail
+    // is skipped until its input comes back.
+    for (const auto op : fxChain.getProgram())
+    {
+        auto& silentSamples = stageSilentSamples[(size_t) getProfileStage (op)];
+        const auto tail = getTailSamples (op);
+
+        if (silent && silentSamples >= tail)
+        {
+            silentSamples = juce::jmin (silentSamples + numSamples, std::numeric_limits<int>::max() / 2);
+
+            if (timing != nullptr)
+                timing->mark (getProfileStage (op));
+
+            continue;
+        }
+
+        if (soulbass::FxProgram::isFused (op))
+        {
+            processFusedStage (buffer, op);
+        }
+        else
+        {
+            switch (op)
+            {
+                case soulbass::FxProgram::dynamicsOp: dynamics.process (context); break;
+                case soulbass::FxProgram::chorusOp:   chorus.process (context); break;
+                case soulbass::FxProgram::delayOp:    processDelay (buffer); break;
+                case soulbass::FxProgram::reverbOp:   processReverb (context, buffer.getNumSamples()); break;
+                default: break;
+            }
+        }
 
-    const bool eqOn = apvts.getRawParameterValue ("eqEnabled")->load();
-    const bool dynOn = apvts.getRawParameterValue ("dynEnabled")->load();
-    const bool shaperOn = apvts.getRawParameterValue ("shaperEnabled")->load();
-    const bool chorusOn = apvts.getRawParameterValue ("chorusEnabled")->load();
-    const bool delayOn = apvts.getRawParameterValue ("delayEnabled")->load();
-    const bool reverbOn = apvts.getRawParameterValue ("reverbEnabled")->load();
+        const bool wasSilent = silent;
+        silent = isSilent (buffer);
+        silentSamples = wasSilent && silent ? juce::jmin (silentSamples + numSamples, std::numeric_limits<int>::max() / 2) : 0;
+        allDecayed = allDecayed && silentSamples >= tail;
 
-    if (eqOn)
+        if (timing != nullptr)
+            timing->mark (getProfileStage (op));
+    }
+
+    fxTailsDecayed = allDecayed;
+}
+
+int SoulBassAudioProcessor::getTailSamples (juce::uint8 op) const
+{
+    // Generous bounds: past these, silence in means silence out.
+    const auto sr = processSpec.sampleRate;
+    const auto ms = [sr] (double milliseconds) { return (int) (sr * milliseconds * 0.001); };
+
+    switch (op)
     {
-        eqLow.process (context);
-        eqMid.process (context);
-        eqHigh.process (context);
+        case soulbass::FxProgram::dynamicsOp: return dynamics.getTailSamples();        // until the release has settled
+        case soulbass::FxProgram::chorusOp:   return ms (50.0);
+        case soulbass::FxProgram::delayOp:    return (int) delaySamples + ms (50.0);   // one full pass of the line
+        case soulbass::FxProgram::reverbOp:   return ms (200.0);
+        default:                              return ms (50.0);                        // EQ ringing
     }
+}
 
-    if (dynOn)
-        compressor.process (context);
+void SoulBassAudioProcessor::processFusedStage (juce::AudioBuffer<float>& buffer, juce::uint8 op)
+{
+    const auto middle = soulbass::FxProgram::getMiddle (op);
+    const bool applyInputGain = soulbass::FxProgram::hasInputGain (op);
+    const bool applyOutputGain = soulbass::FxProgram::hasOutputGain (op);
 
-    if (shaperOn)
+    // The high-quality profile splits the runs, so the shaper arrives on its own.
+    if (middle == soulbass::FusedMiddle::shaper && ! applyInputGain && ! applyOutputGain && oversampleShaper)
     {
-        const auto numSamples = buffer.getNumSamples();
-        const auto numChannels = buffer.getNumChannels();
-        for (int ch = 0; ch < numChannels; ++ch)
+        processShaperOversampled (buffer);
+        return;
+    }
+
+    auto fillRamp = [] (juce::SmoothedValue<float>& gain, float* dest, int num)
+    {
+        if (! gain.isSmoothing())
         {
-            auto* data = buffer.getWritePointer (ch);
-            for (int i = 0; i < numSamples; ++i)
-                data[i] = shaperFn ? shaperFn (data[i]) : data[i];
+            juce::FloatVectorOperations::fill (dest, gain.getNextValue(), num);
+            return;
         }
+
+        for (int i = 0; i < num; ++i)
+            dest[i] = gain.getNextValue();
+    };
+
+    const auto numSamples = buffer.getNumSamples();
+    const auto numChannels = juce::jmin (2, buffer.getNumChannels());
+    const auto chunkSize = juce::jmax (1, (int) inputGainRamp.size());
+
+    // Hosts may exceed the prepared block size, so walk the scratch in chunks.
+    for (int offset = 0; offset < numSamples; offset += chunkSize)
+    {
+        const auto num = juce::jmin (chunkSize, numSamples - offset);
+
+        if (applyInputGain)
+            fillRamp (inputGain, inputGainRamp.data(), num);
+        if (applyOutputGain)
+            fillRamp (outputGain, outputGainRamp.data(), num);
+
+        float* channels[2] { buffer.getWritePointer (0, offset),
+                             buffer.getWritePointer (numChannels - 1, offset) };
+
+        soulbass::runFusedStage (middle, applyInputGain, applyOutputGain,
+                                 { channels, numChannels, num, inputGainRamp.data(), outputGainRamp.data(), eq, shaper });
+    }
+
+    if (middle != soulbass::FusedMiddle::none && middle != soulbass::FusedMiddle::shaper)
+        eq.snapToZero();
+}
+
+void SoulBassAudioProcessor::processShaperOversampled (juce::AudioBuffer<float>& buffer)
+{
+    if (! shaperOversamplerPrimed)
+    {
+        shaperOversampler.reset();
+        shaperOversamplerPrimed = true;
     }
 
-    if (chorusOn)
-        chorus.process (context);
+    juce::dsp::AudioBlock<float> block (buffer);
+    const auto numSamples = buffer.getNumSamples();
+    const auto chunkSize = juce::jmax (1, (int) inputGainRamp.size());
 
-    if (delayOn)
+    for (int offset = 0; offset < numSamples; offset += chunkSize)
     {
-        const float feedback = apvts.getRawParameterValue ("delayFeedback")->load();
-        const auto numSamples = buffer.getNumSamples();
-        const auto numChannels = buffer.getNumChannels();
-        for (int ch = 0; ch < numChannels; ++ch)
+        auto chunk = block.getSubBlock ((size_t) offset, (size_t) juce::jmin (chunkSize, numSamples - offset));
+        auto upsampled = shaperOversampler.processSamplesUp (chunk);
+
+        for (size_t ch = 0; ch < upsampled.getNumChannels(); ++ch)
         {
-            auto* data = buffer.getWritePointer (ch);
-            auto& delay = delayLines[(size_t) juce::jmin (ch, (int) delayLines.size() - 1)];
+            auto* data = upsampled.getChannelPointer (ch);
+            for (size_t i = 0; i < upsampled.getNumSamples(); ++i)
+                data[i] = shaper.processSample (data[i]);
+        }
 
-            for (int i = 0; i < numSamples; ++i)
-            {
-                const float dry = data[i];
-                const float delayed = delay.popSample (ch, (float) delaySamples);
-                data[i] = dry + delayed * delayMix;
-                delay.pushSample (ch, dry + delayed * feedback);
-            }
+        shaperOversampler.processSamplesDown (chunk);
+    }
+}
+
+void SoulBassAudioProcessor::processDelay (juce::AudioBuffer<float>& buffer)
+{
+    const float feedback = apvts.getRawParameterValue ("delayFeedback")->load();
+    const auto numSamples = buffer.getNumSamples();
+    const auto numChannels = buffer.getNumChannels();
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* data = buffer.getWritePointer (ch);
+        auto& delay = delayLines[(size_t) juce::jmin (ch, (int) delayLines.size() - 1)];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float dry = data[i];
+            const float delayed = delay.popSample (ch, (float) delaySamples);
+            data[i] = dry + delayed * delayMix;
+            delay.pushSample (ch, dry + delayed * feedback);
         }
     }
+}
 
-    if (reverbOn)
-        reverb.process (context);
+void SoulBassAudioProcessor::processReverb (const juce::dsp::ProcessContextReplacing<float>& context, int numSamples)
+{
+    juce::AudioProcessLoadMeasurer::ScopedTimer timer (reverbLoad, numSamples);
 
-    outputGain.process (context);
+    const bool useConvolution = apvts.getRawParameterValue ("reverbEngine")->load() > 0.5f
+                                && ! governor.isDegraded (soulbass::QualityStep::reverbLines);
+
+    // Whichever engine comes back in starts from silence, not from a stale tail.
+    if (useConvolution != convolutionActive)
+    {
+        convolutionActive = useConvolution;
+        if (useConvolution)
+            convolutionReverb.reset();
+        else
+            reverb.reset();
+    }
+
+    if (useConvolution)
+        convolutionReverb.process (context);
+    else
+        reverb.process (context);
 }
 
-void SoulBassAudioProcessor::loadSamples()
+bool SoulBassAudioProcessor::hasSoundForNote (int midiNoteNumber) const
 {
-    if (samplesLoaded)
-        return;
+    for (int i = 0; i < synth.getNumSounds(); ++i)
+        if (synth.getSound (i)->appliesToNote (midiNoteNumber))
+            return true;
+
+    return false;
+}
 
-    auto toResourceName = [] (const juce::String& fileName)
+void SoulBassAudioProcessor::traceFxBypassChanges()
+{
+    for (int s = 0; s < soulbass::numFxStages; ++s)
     {
-        // Mirror JUCE's BinaryData identifier generation.
-        juce::String cleaned;
-        for (int i = 0; i < fileName.length(); ++i)
+        const bool enabled = apvts.getRawParameterValue (soulbass::getFxStageEnableParameter ((soulbass::FxStage) s))->load() > 0.5f;
+
+        if (enabled != tracedFxEnabled[(size_t) s])
         {
-            auto c = fileName[i];
-            const bool first = (i == 0);
-            const bool isLetter = juce::CharacterFunctions::isLetter (c);
-            const bool isDigit = juce::CharacterFunctions::isDigit (c);
-            const bool allowed = first ? (isLetter || c == '_') : (isLetter || isDigit || c == '_');
-            cleaned << (allowed ? juce::String::charToString (c) : juce::String ("_"));
+            tracedFxEnabled[(size_t) s] = enabled;
+            trace.record (soulbass::TraceEventType::fxBypass, 0, s, enabled ? 1 : 0);
         }
+    }
+}
 
-        if (cleaned.isEmpty() || !(juce::CharacterFunctions::isLetter (cleaned[0]) || cleaned[0] == '_'))
-            cleaned = "_" + cleaned;
-
-        return cleaned;
-    };
+void SoulBassAudioProcessor::loadSamples()
+{
+    if (samplesLoaded)
+        return;
 
-    const int numVoices = 16;
-    while (synth.getNumVoices() < numVoices)
+    while (synth.getNumVoices() < kMaxVoices)
         synth.addVoice (new soulbass::SampleVoice());
 
     int midiNote = kStartNote;
+    juce::StringArray names;
 
-    for (auto* name : kSampleNames)
+    for (const auto& bundled : kSamples)
     {
-        int dataSize = 0;
-        auto resourceName = toResourceName (juce::File (name).getFileName());
-        if (auto* data = BinaryData::getNamedResource (resourceName.toRawUTF8(), dataSize))
-        {
-            auto stream = std::make_unique<juce::MemoryInputStream> (data, (size_t) dataSize, false);
-            auto reader = std::unique_ptr<juce::AudioFormatReader> (formatManager.createReaderFor (std::move (stream)));
-
-            if (reader != nullptr)
-            {
-                auto length = (int) reader->lengthInSamples;
-                auto buffer = std::make_unique<juce::AudioBuffer<float>> ((int) reader->numChannels, length);
-                reader->read (buffer.get(), 0, length, 0, true, true);
-
-                auto sound = std::make_unique<soulbass::SampleSound> (name,
-                                                                      std::move (buffer),
-                                                                      reader->sampleRate,
-                                                                      midiNote,
-                                                                      midiNote,
-                                                                      midiNote);
-                synth.addSound (sound.release());
-            }
-        }
+        auto sample = soulbass::SampleLibrary::load (bundled.name);
+        names.add (bundled.name);
+
+        if (sample.data != nullptr)
+            synth.addSound (new soulbass::SampleSound (bundled.name,
+                                                       std::move (sample.data),
+                                                       sample.sampleRate,
+                                                       midiNote,
+                                                       midiNote,
+                                                       midiNote,
+                                                       bundled.rootHz,
+                                                       std::move (sample.sustain)));
 
         ++midiNote;
     }
 
+    // The steady samples' sustain tables are built in the background.
+    sustainLoader.start (names);
+
     updateVoices();
     samplesLoaded = true;
 }
@@ -256,10 +627,21 @@ void SoulBassAudioProcessor::updateVoices()
 {
     for (int i = synth.getNumVoices(); --i >= 0;)
         if (auto* v = dynamic_cast<soulbass::SampleVoice*> (synth.getVoice (i)))
+        {
             v->prepare (processSpec);
+            v->setTrace (&trace, i);
+            v->setModMatrix (&modMatrix);
+            v->setRandomSeed (i + 1);
+        }
 }
 
-void SoulBassAudioProcessor::updateVoiceParameters()
+// Offline bounces always spread voices across cores; live it's opt-in.
+bool SoulBassAudioProcessor::shouldRenderVoicesInParallel() const
+{
+    return isNonRealtime() || apvts.getRawParameterValue ("multicoreVoices")->load() > 0.5f;
+}
+
+void SoulBassAudioProcessor::updateVoiceParameters (int numSamples)
 {
     const auto* attack = apvts.getRawParameterValue ("attack");
     const auto* decay = apvts.getRawParameterValue ("decay");
@@ -279,13 +661,27 @@ void SoulBassAudioProcessor::updateVoiceParameters()
     const auto* glideOn = apvts.getRawParameterValue ("glideEnabled");
     const auto* glideDirection = apvts.getRawParameterValue ("glideDirection");
     const auto* glideTime = apvts.getRawParameterValue ("glideTime");
+    const auto* glideMode = apvts.getRawParameterValue ("glideMode");
+    const auto* glideLegato = apvts.getRawParameterValue ("glideLegato");
     const auto* polyphony = apvts.getRawParameterValue ("polyphony");
     const auto* legato = apvts.getRawParameterValue ("legato");
     const auto* retrigger = apvts.getRawParameterValue ("retrigger");
+    const auto* unisonVoices = apvts.getRawParameterValue ("unisonVoices");
+    const auto* unisonDetune = apvts.getRawParameterValue ("unisonDetune");
+    const auto* unisonSpread = apvts.getRawParameterValue ("unisonSpread");
+    const auto* unisonPhase = apvts.getRawParameterValue ("unisonPhase");
+    const auto* subWaveform = apvts.getRawParameterValue ("subWaveform");
+    const auto* subOctave = apvts.getRawParameterValue ("subOctave");
+    const auto* subLevel = apvts.getRawParameterValue ("subLevel");
 
     juce::ADSR::Parameters env { attack->load(), decay->load(), sustain->load(), release->load() };
 
-    auto type = filterType->load() < 0.5f ? soulbass::FilterType::lowPass : soulbass::FilterType::highPass;
+    const auto type = (soulbass::FilterType) juce::jlimit (0, 4, (int) std::round (filterType->load()));
+
+    // Both take effect from the next note, so sounding notes keep their timbre.
+    auto unisonLanes = (int) std::round (unisonVoices->load());
+    if (governor.isDegraded (soulbass::QualityStep::unisonLanes))
+        unisonLanes = juce::jmin (2, unisonLanes);
 
     const int pitchRanges[] { 2, 7, 12, 24 };
     const int rangeIdx = juce::jlimit (0, 3, (int) std::round (pitchRange->load()));
@@ -295,6 +691,8 @@ void SoulBassAudioProcessor::updateVoiceParameters()
     const int polyIdx = juce::jlimit (0, 5, (int) std::round (polyphony->load()));
     const int targetVoices = polyChoices[polyIdx];
 
+    synth.setParallelRenderingEnabled (shouldRenderVoicesInParallel());
+
     // Grow/shrink voice pool to requested polyphony.
     bool voiceCountChanged = false;
     while (synth.getNumVoices() < targetVoices)
@@ -315,15 +713,92 @@ void SoulBassAudioProcessor::updateVoiceParameters()
         if (auto* v = dynamic_cast<soulbass::SampleVoice*> (synth.getVoice (i)))
         {
             v->setEnvelope (env);
+            v->setLadderLimited (governor.isDegraded (soulbass::QualityStep::filterModel));
             v->setFilter (type, filterCutoff->load(), filterRes->load());
             const float lfoDepthValue = lfoEnabled->load() > 0.5f ? lfoDepth->load() : 0.0f;
             v->setLfo (lfoRate->load(), lfoDepthValue, lfoPhase->load(), lfoSmooth->load());
+            v->setControlRampLength (midiCoalescer.getResolution());
             v->setModWheel (currentModWheel);
             v->setPitchBendRange (pitchRangeSemis);
-            v->setGlide (glideOn->load() > 0.5f, glideTime->load(), (int) std::round (glideDirection->load()));
+            v->setGlide (glideOn->load() > 0.5f, glideTime->load(),
+                         (soulbass::Portamento::Direction) juce::jlimit (0, 2, (int) std::round (glideDirection->load())),
+                         (soulbass::Portamento::Mode) juce::jlimit (0, 1, (int) std::round (glideMode->load())),
+                         glideLegato->load() > 0.5f);
             v->setLegato (legato->load() > 0.5f, retrigger->load() > 0.5f);
+            v->setUnison (unisonLanes, unisonDetune->load(), unisonSpread->load(), unisonPhase->load());
+            v->setSubOscillator ((soulbass::SubOscillator::Waveform) juce::jlimit (0, 3, (int) std::round (subWaveform->load())),
+                                 1 + (int) std::round (subOctave->load()), subLevel->load());
+            v->setInterpolation (highQuality.load() ? soulbass::Interpolation::sinc : soulbass::Interpolation::linear);
+            v->setControlInterval (governor.isDegraded (soulbass::QualityStep::controlRate) ? 16 : 1);
+        }
+    }
+
+    synth.setVoiceLimit (governor.isDegraded (soulbass::QualityStep::voiceLimit) ? juce::jmax (1, targetVoices / 2) : 0);
+
+    updateModulation (numSamples);
+}
+
+void SoulBassAudioProcessor::updateModulation (int numSamples)
+{
+    std::array<soulbass::ModMatrix::Slot, (size_t) soulbass::numModSlots> slots;
+
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        const auto& p = modSlotParameters[i];
+        slots[i] = { (int) std::round (p[0]->load()) - 1, (int) std::round (p[1]->load()), p[2]->load() };
+    }
+
+    modMatrix.setSlots (slots);
+
+    // Nothing routed, and the voices already know it: nothing to do.
+    if (! modMatrix.isActive() && ! modMatrixWasActive)
+        return;
+
+    modMatrixWasActive = modMatrix.isActive();
+
+    // One matrix row per sounding voice.
+    std::array<soulbass::SampleVoice*, (size_t) soulbass::ModMatrix::maxVoices> rows {};
+    int numRows = 0;
+
+    for (int i = 0; i < synth.getNumVoices() && numRows < soulbass::ModMatrix::maxVoices; ++i)
+    {
+        if (auto* v = dynamic_cast<soulbass::SampleVoice*> (synth.getVoice (i)); v != nullptr && v->isVoiceActive())
+        {
+            modMatrix.setSources (numRows, v->getModSources());
+            rows[(size_t) numRows++] = v;
+        }
+    }
+
+    // With nothing sounding, the FX still follow the performance controllers.
+    if (numRows == 0)
+    {
+        modMatrix.setSource (0, soulbass::ModSource::lfo, 0.0f);
+        modMatrix.setSource (0, soulbass::ModSource::envelope, 0.0f);
+        modMatrix.setSource (0, soulbass::ModSource::velocity, 0.0f);
+        modMatrix.setSource (0, soulbass::ModSource::modWheel, currentModWheel);
+        modMatrix.setSource (0, soulbass::ModSource::aftertouch, currentPressure);
+        modMatrix.setSource (0, soulbass::ModSource::pitchBend, currentPitchBend);
+    }
+
+    modMatrix.setNumVoices (juce::jmax (1, numRows));
+    modMatrix.process();
+
+    // Idle voices go back to neutral; a note started during the block routes its
+    // own sources in startNote.
+    for (int i = 0, row = 0; i < synth.getNumVoices(); ++i)
+    {
+        if (auto* v = dynamic_cast<soulbass::SampleVoice*> (synth.getVoice (i)))
+        {
+            if (row < numRows && rows[(size_t) row] == v)
+                v->setModulation (modMatrix.getVoiceModulation (row++), numSamples);
+            else
+                v->setModulation ({}, numSamples);
         }
     }
+
+    for (size_t d = 0; d < fxModulation.size(); ++d)
+        fxModulation[d].store (modMatrix.getMeanDestination ((soulbass::ModDestination) (soulbass::numVoiceModDestinations + (int) d)),
+                               std::memory_order_relaxed);
 }
 
 void SoulBassAudioProcessor::updateFxParameters()
@@ -338,7 +813,7 @@ void SoulBassAudioProcessor::updateFxParameters()
 
     if (auto coeff = juce::dsp::IIR::Coefficients<float>::makeLowShelf (sr, lowFreq, lowQ,
                                                                         juce::Decibels::decibelsToGain (lowGain)))
-        *eqLow.state = *coeff;
+        eq.setBandCoefficients (0, *coeff);
 
     const auto midFreq = apvts.getRawParameterValue ("eqMidFreq")->load();
     const auto midGain = apvts.getRawParameterValue ("eqMidGain")->load();
@@ -346,7 +821,7 @@ void SoulBassAudioProcessor::updateFxParameters()
 
     if (auto coeff = juce::dsp::IIR::Coefficients<float>::makePeakFilter (sr, midFreq, midQ,
                                                                           juce::Decibels::decibelsToGain (midGain)))
-        *eqMid.state = *coeff;
+        eq.setBandCoefficients (1, *coeff);
 
     const auto highFreq = apvts.getRawParameterValue ("eqHighFreq")->load();
     const auto highGain = apvts.getRawParameterValue ("eqHighGain")->load();
@@ -354,48 +829,55 @@ void SoulBassAudioProcessor::updateFxParameters()
 
     if (auto coeff = juce::dsp::IIR::Coefficients<float>::makeHighShelf (sr, highFreq, highQ,
                                                                          juce::Decibels::decibelsToGain (highGain)))
-        *eqHigh.state = *coeff;
+        eq.setBandCoefficients (2, *coeff);
 
     const auto dynThreshold = apvts.getRawParameterValue ("dynThreshold")->load();
     const auto dynAttack = apvts.getRawParameterValue ("dynAttack")->load();
     const auto dynRatio = apvts.getRawParameterValue ("dynRatio")->load();
     const auto dynRelease = apvts.getRawParameterValue ("dynRelease")->load();
+    const auto dynLookahead = apvts.getRawParameterValue ("dynLookahead")->load();
     const bool dynLimit = apvts.getRawParameterValue ("dynLimit")->load() > 0.5f;
+    const bool dynOn = apvts.getRawParameterValue ("dynEnabled")->load() > 0.5f;
 
-    compressor.setThreshold (dynThreshold);
-    compressor.setRatio (dynLimit ? juce::jmax (10.0f, dynRatio * 2.0f) : dynRatio);
-    compressor.setAttack (dynAttack);
-    compressor.setRelease (dynRelease);
+    dynamics.setExactMath (referencePath.load());
+    dynamics.setParameters (dynLimit ? soulbass::DynamicsProcessor::Mode::limit : soulbass::DynamicsProcessor::Mode::compress,
+                            dynThreshold, dynRatio, dynAttack, dynRelease, dynLookahead);
+
+    // The limiter and the offline shaper oversampler delay the signal;
+    // processBlock reports it to the host.
+    const bool shaperOn = apvts.getRawParameterValue ("shaperEnabled")->load() > 0.5f;
+    fxLatency.store ((dynOn ? dynamics.getLatencySamples() : 0)
+                     + (shaperOn && oversampleShaper ? juce::roundToInt (shaperOversampler.getLatencyInSamples()) : 0));
 
     const auto shaperDriveDb = apvts.getRawParameterValue ("shaperDrive")->load();
     const auto shaperBias = apvts.getRawParameterValue ("shaperBias")->load();
     const auto shaperType = (int) std::round (apvts.getRawParameterValue ("shaperType")->load());
-    const float drive = juce::Decibels::decibelsToGain (shaperDriveDb);
 
-    shaperFn = [drive, shaperBias, shaperType] (float x)
+    const auto fxMod = [this] (soulbass::ModDestination d)
     {
-        const float biased = (x + shaperBias) * drive;
-        switch (shaperType)
-        {
-            case 1: // Tube-ish
-                return juce::jlimit (-1.2f, 1.2f, std::tanh (biased) * 0.8f);
-            case 2: // Tape-ish soft clip
-            {
-                const float s = juce::jlimit (-2.5f, 2.5f, biased);
-                return s - (s * s * s) * 0.08f;
-            }
-            default: // Soft clip
-                return juce::jlimit (-1.0f, 1.0f, biased / (1.0f + std::abs (biased)));
-        }
+        return fxModulation[(size_t) ((int) d - soulbass::numVoiceModDestinations)].load (std::memory_order_relaxed);
     };
 
-    const auto chorusRate = apvts.getRawParameterValue ("chorusRate")->load();
-    const auto chorusBlend = apvts.getRawParameterValue ("chorusBlend")->load();
-    chorus.setRate (chorusRate);
-    chorus.setDepth (0.45f);
-    chorus.setCentreDelay (7.5f);
-    chorus.setFeedback (0.12f);
-    chorus.setMix (chorusBlend);
+    shaper.drive = juce::Decibels::decibelsToGain (juce::jlimit (0.0f, 48.0f, shaperDriveDb + 24.0f * fxMod (soulbass::ModDestination::shaperDrive)));
+    shaper.bias = shaperBias;
+    shaper.type = shaperType;
+
+    const auto chorusBlend = juce::jlimit (0.0f, 1.0f, apvts.getRawParameterValue ("chorusBlend")->load()
+                                                           + fxMod (soulbass::ModDestination::chorusBlend));
+    const auto chorusVoices = (int) std::round (apvts.getRawParameterValue ("chorusVoices")->load());
+    const auto chorusCrossover = apvts.getRawParameterValue ("chorusCrossover")->load();
+    auto chorusRate = apvts.getRawParameterValue ("chorusRate")->load();
+
+    if (apvts.getRawParameterValue ("chorusSync")->load() > 0.5f)
+    {
+        const float beatsPerCycle[] { 1.0f, 2.0f, 4.0f, 8.0f, 16.0f };
+        const auto syncIdx = juce::jlimit (0, 4, (int) std::round (apvts.getRawParameterValue ("chorusSyncRate")->load()));
+        chorusRate = (float) (hostBpm.load() / 60.0) / beatsPerCycle[syncIdx];
+    }
+
+    chorus.setParameters (chorusRate, chorusBlend,
+                          governor.isDegraded (soulbass::QualityStep::reverbLines) ? juce::jmin (2, chorusVoices) : chorusVoices,
+                          chorusCrossover);
 
     const auto delayMs = apvts.getRawParameterValue ("delayTimeMs")->load();
     delaySamples = (size_t) juce::jlimit (1, 192000, (int) std::round (delayMs * sr / 1000.0));
@@ -407,7 +889,8 @@ void SoulBassAudioProcessor::updateFxParameters()
         for (auto& d : delayLines)
             d.reset();
 
-    const auto reverbBlend = apvts.getRawParameterValue ("reverbBlend")->load();
+    const auto reverbBlend = juce::jlimit (0.0f, 1.0f, apvts.getRawParameterValue ("reverbBlend")->load()
+                                                           + fxMod (soulbass::ModDestination::reverbBlend));
     const auto reverbDecay = apvts.getRawParameterValue ("reverbDecay")->load();
     const auto reverbType = (int) std::round (apvts.getRawParameterValue ("reverbType")->load());
 
@@ -431,6 +914,12 @@ void SoulBassAudioProcessor::updateFxParameters()
     }
 
     reverb.setParameters (params);
+
+    // Hall has no dedicated IR; it reuses the plate with the longer decay.
+    convolutionReverb.setParameters (reverbType == 0 ? soulbass::ConvolutionReverb::Impulse::spring
+                                                     : soulbass::ConvolutionReverb::Impulse::plate,
+                                     reverbDecay,
+                                     reverbBlend);
 }
 juce::AudioProcessorValueTreeState::ParameterLayout SoulBassAudioProcessor::createParameterLayout()
 {
@@ -446,7 +935,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout SoulBassAudioProcessor::crea
 
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("filterCutoff", "Filter Cutoff", juce::NormalisableRange<float> (40.0f, 20000.0f, 0.0f, 0.35f), 1200.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("filterResonance", "Filter Resonance", 0.1f, 2.0f, 0.7f));
-    params.push_back (std::make_unique<juce::AudioParameterChoice> ("filterType", "Filter Type", juce::StringArray { "LPF", "HPF" }, 0));
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("filterType", "Filter Type", juce::StringArray { "LPF", "HPF", "BPF", "Notch", "Ladder" }, 0));
 
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("lfoRate", "LFO Rate", juce::NormalisableRange<float> (0.1f, 12.0f, 0.0f, 0.3f), 2.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("lfoDepth", "LFO Depth", 0.0f, 1.0f, 0.5f));
@@ -479,6 +968,8 @@ juce::AudioProcessorValueTreeState::ParameterLayout SoulBassAudioProcessor::crea
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("dynAttack", "Dynamics Attack", juce::NormalisableRange<float> (1.0f, 50.0f, 0.0f, 0.4f), 10.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("dynRatio", "Dynamics Ratio", 1.0f, 20.0f, 4.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("dynRelease", "Dynamics Release", juce::NormalisableRange<float> (20.0f, 400.0f, 0.0f, 0.4f), 80.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("dynLookahead", "Limiter Lookahead",
+                                                                   juce::NormalisableRange<float> (0.0f, soulbass::DynamicsProcessor::maxLookaheadMs, 0.0f, 0.5f), 1.5f));
 
     // Shaper
     params.push_back (std::make_unique<juce::AudioParameterBool> ("shaperEnabled", "Shaper Enabled", true));
@@ -491,6 +982,12 @@ juce::AudioProcessorValueTreeState::ParameterLayout SoulBassAudioProcessor::crea
     params.push_back (std::make_unique<juce::AudioParameterBool> ("chorusEnabled", "Chorus Enabled", true));
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("chorusRate", "Chorus Rate", juce::NormalisableRange<float> (0.1f, 5.0f, 0.0f, 0.35f), 1.2f));
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("chorusBlend", "Chorus Blend", 0.0f, 1.0f, 0.35f));
+    params.push_back (std::make_unique<juce::AudioParameterInt> ("chorusVoices", "Chorus Voices", 2, soulbass::EnsembleChorus::maxVoices, 3));
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("chorusSync", "Chorus Tempo Sync", false));
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("chorusSyncRate", "Chorus Sync Rate",
+                                                                    juce::StringArray { "1/4", "1/2", "1/1", "2/1", "4/1" }, 2));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("chorusCrossover", "Chorus Crossover",
+                                                                   juce::NormalisableRange<float> (40.0f, 400.0f, 0.0f, 0.5f), 150.0f));
 
     // Delay
     params.push_back (std::make_unique<juce::AudioParameterBool> ("delayEnabled", "Delay Enabled", true));
@@ -503,18 +1000,57 @@ juce::AudioProcessorValueTreeState::ParameterLayout SoulBassAudioProcessor::crea
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("reverbDecay", "Reverb Decay", juce::NormalisableRange<float> (0.2f, 4.0f, 0.0f, 0.35f), 1.5f));
     params.push_back (std::make_unique<juce::AudioParameterChoice> ("reverbType", "Reverb Type",
                                                                     juce::StringArray { "Spring", "Hall", "Plate" }, 0));
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("reverbEngine", "Reverb Engine",
+                                                                    juce::StringArray { "Algorithmic", "Convolution" }, 0));
 
     // Pitch / glide / poly
     params.push_back (std::make_unique<juce::AudioParameterChoice> ("pitchRange", "Pitch Bend Range",
                                                                     juce::StringArray { "2", "7", "12", "24" }, 2));
     params.push_back (std::make_unique<juce::AudioParameterBool> ("glideEnabled", "Glide Enabled", false));
     params.push_back (std::make_unique<juce::AudioParameterChoice> ("glideDirection", "Glide Direction",
-                                                                    juce::StringArray { "Up", "Down" }, 0));
+                                                                    juce::StringArray { "Up", "Down", "Both" }, 0));
     params.push_back (std::make_unique<juce::AudioParameterFloat> ("glideTime", "Glide Time", juce::NormalisableRange<float> (0.0f, 0.4f, 0.0f, 0.4f), 0.08f));
+    // In "Rate" mode the glide time is per octave.
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("glideMode", "Glide Mode",
+                                                                    juce::StringArray { "Time", "Rate" }, 0));
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("glideLegato", "Legato Glide", false));
     params.push_back (std::make_unique<juce::AudioParameterChoice> ("polyphony", "Polyphony",
                                                                     juce::StringArray { "1", "2", "3", "4", "8", "16" }, 2));
     params.push_back (std::make_unique<juce::AudioParameterBool> ("legato", "Legato", false));
     params.push_back (std::make_unique<juce::AudioParameterBool> ("retrigger", "Retrigger", true));
+    // Unison is host-only: the editor has no controls for it (COMPONENT_LAYOUT.md).
+    params.push_back (std::make_unique<juce::AudioParameterInt> ("unisonVoices", "Unison Voices", 1, soulbass::UnisonStack::maxVoices, 1));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("unisonDetune", "Unison Detune", juce::NormalisableRange<float> (0.0f, 100.0f, 0.0f, 0.5f), 20.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("unisonSpread", "Unison Spread", 0.0f, 1.0f, 0.7f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("unisonPhase", "Unison Phase Random", 0.0f, 1.0f, 1.0f));
+
+    // Sub oscillator, host-only like unison
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("subWaveform", "Sub Waveform",
+                                                                    juce::StringArray { "Sine", "Triangle", "Square", "Saw" }, 0));
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("subOctave", "Sub Octave",
+                                                                    juce::StringArray { "-1", "-2" }, 0));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> ("subLevel", "Sub Level", 0.0f, 1.0f, 0.0f));
+
+    // Modulation matrix slots, host-only like unison
+    auto modSources = soulbass::getModSourceNames();
+    modSources.insert (0, "None");
+
+    for (int i = 1; i <= soulbass::numModSlots; ++i)
+    {
+        const auto id = "mod" + juce::String (i);
+        const auto name = "Mod " + juce::String (i);
+
+        params.push_back (std::make_unique<juce::AudioParameterChoice> (id + "Source", name + " Source",
+                                                                        modSources, 0));
+        params.push_back (std::make_unique<juce::AudioParameterChoice> (id + "Destination", name + " Destination",
+                                                                        soulbass::getModDestinationNames(), 0));
+        params.push_back (std::make_unique<juce::AudioParameterFloat> (id + "Amount", name + " Amount", -1.0f, 1.0f, 0.0f));
+    }
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("multicoreVoices", "Multicore Voices", false));
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("pipelinedFx", "Pipelined FX", false));
+    params.push_back (std::make_unique<juce::AudioParameterBool> ("cpuGovernor", "CPU Governor", false));
+    params.push_back (std::make_unique<juce::AudioParameterChoice> ("subBlockSize", "Internal Block",
+                                                                    juce::StringArray { "Host", "32", "64" }, 0));
 
     return { params.begin(), params.end() };
 }
@@ -527,6 +1063,7 @@ juce::AudioProcessorEditor* SoulBassAudioProcessor::createEditor()
 void SoulBassAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
     auto state = apvts.copyState();
+    state.setProperty ("fxOrder", soulbass::fxOrderToString (fxChain.getOrder()), nullptr);
     std::unique_ptr<juce::XmlElement> xml (state.createXml());
     copyXmlToBinary (*xml, destData);
 }
@@ -537,7 +1074,61 @@ void SoulBassAudioProcessor::setStateInformation (const void* data, int sizeInBy
 
     if (xmlState != nullptr)
         if (xmlState->hasTagName (apvts.state.getType()))
+        {
             apvts.replaceState (juce::ValueTree::fromXml (*xmlState));
+
+            // Older sessions have no order saved; they get the original fixed chain.
+            auto order = soulbass::getDefaultFxOrder();
+            soulbass::fxOrderFromString (apvts.state.getProperty ("fxOrder").toString(), order);
+            fxChain.setOrder (order);
+        }
+}
+
+void SoulBassAudioProcessor::setFxOrder (const soulbass::FxOrder& order)
+{
+    fxChain.setOrder (order);
+}
+
+void SoulBassAudioProcessor::setProfilingEnabled (bool shouldBeEnabled)
+{
+    profiler.setEnabled (shouldBeEnabled);
+    updateSplitRuns();
+}
+
+void SoulBassAudioProcessor::setMaxVoiceWorkers (int numWorkers)
+{
+    maxVoiceWorkers.store (juce::jmax (0, numWorkers));
+}
+
+void SoulBassAudioProcessor::setReferencePathEnabled (bool shouldBeEnabled)
+{
+    referencePath.store (shouldBeEnabled);
+    updateSplitRuns();
+}
+
+juce::uint32 SoulBassAudioProcessor::getAvailableQualitySteps() const
+{
+    auto enabled = [this] (const char* id) { return apvts.getRawParameterValue (id)->load() > 0.5f; };
+    const auto chorusVoices = (int) std::round (apvts.getRawParameterValue ("chorusVoices")->load());
+
+    juce::uint32 mask = 1u << (int) soulbass::QualityStep::controlRate;
+
+    if ((int) std::round (apvts.getRawParameterValue ("filterType")->load()) == (int) soulbass::FilterType::ladder)
+        mask |= 1u << (int) soulbass::QualityStep::filterModel;
+    if ((int) std::round (apvts.getRawParameterValue ("unisonVoices")->load()) > 2)
+        mask |= 1u << (int) soulbass::QualityStep::unisonLanes;
+    if ((enabled ("reverbEnabled") && enabled ("reverbEngine")) || (enabled ("chorusEnabled") && chorusVoices > 2))
+        mask |= 1u << (int) soulbass::QualityStep::reverbLines;
+    if (synth.getNumVoices() > 1)
+        mask |= 1u << (int) soulbass::QualityStep::voiceLimit;
+
+    return mask;
+}
+
+// Any thread, the audio thread included: this only stores the flag.
+void SoulBassAudioProcessor::updateSplitRuns()
+{
+    fxChain.setSplitRuns (profiler.isEnabled() || referencePath.load() || highQuality.load());
 }
 
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -2,6 +2,17 @@
 
 #include <JuceHeader.h>
 #include "SoulSampler.h"
+#include "SampleLibrary.h"
+#include "ConvolutionReverb.h"
+#include "DynamicsProcessor.h"
+#include "EnsembleChorus.h"
+#include "FxChain.h"
+#include "FxPipeline.h"
+#include "LoadGovernor.h"
+#include "MidiCoalescer.h"
+#include "ModMatrix.h"
+#include "StageProfiler.h"
+#include "SustainLoader.h"
 
 class SoulBassAudioProcessor : public juce::AudioProcessor
 {
@@ -12,6 +23,7 @@ public:
     //==============================================================================
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
+    void reset() override;
 
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
 
@@ -44,37 +56,132 @@ public:
 
     juce::Synthesiser& getSynth() { return synth; }
 
+    // Proportion of the block deadline spent in whichever reverb engine is active.
+    double getReverbLoad() const { return reverbLoad.getLoadAsProportion(); }
+
+    // Current dynamics gain reduction in dB, for metering.
+    float getGainReductionDb() const { return dynamics.getGainReductionDb(); }
+
+    // Order of the FX stages between input and output gain. Saved with the state.
+    void setFxOrder (const soulbass::FxOrder& order);
+    soulbass::FxOrder getFxOrder() const { return fxChain.getOrder(); }
+
+    // Per-stage timing of processBlock. While enabled the fused FX passes are split
+    // up so every stage can be timed on its own.
+    void setProfilingEnabled (bool shouldBeEnabled);
+    const soulbass::StageProfiler& getProfiler() const { return profiler; }
+
+    // Most worker threads used to render voices in parallel (offline, or live with
+    // "Multicore Voices" on). Takes effect at the next prepareToPlay; 0 keeps all
+    // voice rendering on the calling thread. No threads start until parallel
+    // rendering is first used.
+    void setMaxVoiceWorkers (int numWorkers);
+
+    // Pitch bend and continuous controllers are thinned to one value per this
+    // many samples and ramped in between; 1 keeps every event.
+    void setControllerResolution (int numSamples) { controllerResolution.store (juce::jmax (1, numSamples)); }
+
+    // Renders through the plain reference kernels: one pass per FX stage and exact
+    // math instead of the fast approximations. Slower; used to check optimised
+    // paths against.
+    void setReferencePathEnabled (bool shouldBeEnabled);
+    bool isReferencePathEnabled() const noexcept { return referencePath.load(); }
+
+    // Rungs of the quality ladder the CPU governor has currently given up.
+    int getQualityLevel() const noexcept { return governor.getLevel(); }
+
+    // Opt-in Chrome trace of block, voice, note and parameter activity.
+    soulbass::TraceRecorder& getTraceRecorder() { return trace; }
+
 private:
     void loadSamples();
     void updateVoices();
-    void updateVoiceParameters();
+    void updateVoiceParameters (int numSamples);
+    bool shouldRenderVoicesInParallel() const;
+    void updateModulation (int numSamples);
     void updateFxParameters();
 
-    juce::Synthesiser synth;
-    juce::AudioFormatManager formatManager;
+    void renderBlock (juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages, bool pipelined);
+    void processFx (juce::AudioBuffer<float>& buffer, soulbass::StageProfiler::BlockTimer* timing);
+    void processFusedStage (juce::AudioBuffer<float>& buffer, juce::uint8 op);
+    void processShaperOversampled (juce::AudioBuffer<float>& buffer);
+    int getTailSamples (juce::uint8 op) const;
+    void processDelay (juce::AudioBuffer<float>& buffer);
+    void processReverb (const juce::dsp::ProcessContextReplacing<float>& context, int numSamples);
+    bool hasSoundForNote (int midiNoteNumber) const;
+    void traceFxBypassChanges();
+    void updateSplitRuns();
+    juce::uint32 getAvailableQualitySteps() const;
+
+    soulbass::TraceRecorder trace;
+    std::array<bool, (size_t) soulbass::numFxStages> tracedFxEnabled { true, true, true, true, true, true };
+
+    soulbass::SoulSynthesiser synth;
+    soulbass::SustainLoader sustainLoader { synth };
+    soulbass::MidiCoalescer midiCoalescer;
+
+    // Modulation matrix: the slot parameters (source, destination, amount), and
+    // the FX destinations handed on to the FX, which may run on the pipeline
+    // thread.
+    soulbass::ModMatrix modMatrix;
+    std::array<std::array<std::atomic<float>*, 3>, (size_t) soulbass::numModSlots> modSlotParameters {};
+    std::array<std::atomic<float>, (size_t) (soulbass::numModDestinations - soulbass::numVoiceModDestinations)> fxModulation {};
+    bool modMatrixWasActive = false;
+
+    // Fixed internal sub-blocks (the "Internal Block" parameter): the sub-block
+    // being played out, and the MIDI gathered for the next one.
+    juce::AudioBuffer<float> subBlockOutput;
+    juce::MidiBuffer subBlockMidi;
+    int subBlockFill = 0;
+    int activeSubBlockSize = 0;
     juce::dsp::ProcessSpec processSpec { 44100.0, 512, 2 };
 
-    juce::dsp::Gain<float> inputGain;
-    juce::dsp::Gain<float> outputGain;
+    soulbass::FxChain fxChain { apvts };
 
-    using IIRFilter = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>,
-                                                     juce::dsp::IIR::Coefficients<float>>;
+    // Gains are ramped into scratch buffers so they can ride along in the fused pass.
+    juce::SmoothedValue<float> inputGain { 1.0f }, outputGain { 1.0f };
+    std::vector<float> inputGainRamp, outputGainRamp;
 
-    IIRFilter eqLow, eqMid, eqHigh;
-    juce::dsp::Compressor<float> compressor;
-    std::function<float (float)> shaperFn = [] (float x) { return x; };
-    juce::dsp::Chorus<float> chorus;
+    soulbass::ThreeBandEq eq;
+    soulbass::DynamicsProcessor dynamics;
+    soulbass::Shaper shaper;
+    juce::dsp::Oversampling<float> shaperOversampler { 2, 2, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true };
+    bool shaperOversamplerPrimed = false;
+    bool oversampleShaper = false;
+    soulbass::EnsembleChorus chorus;
     std::array<juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear>, 2> delayLines {
         juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear> (192000),
         juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear> (192000)
     };
     juce::dsp::Reverb reverb;
+    soulbass::ConvolutionReverb convolutionReverb;
+    juce::AudioProcessLoadMeasurer reverbLoad;
+    soulbass::StageProfiler profiler;
+
+    // FX-thread silence tracking, per stage and for the chain as a whole.
+    std::array<int, (size_t) soulbass::numProfileStages> stageSilentSamples {};
+    bool fxTailsDecayed = false;
+    soulbass::LoadGovernor governor;
 
     float delayMix = 0.35f;
     size_t delaySamples = 0;
 
+    std::atomic<bool> referencePath { false };
+    std::atomic<bool> highQuality { false };    // offline render profile, follows isNonRealtime()
+    std::atomic<int> maxVoiceWorkers { 7 };
+    std::atomic<int> controllerResolution { 32 };
+
     float currentModWheel = 0.0f;
+    float currentPitchBend = 0.0f, currentPressure = 0.0f;
+    std::atomic<double> hostBpm { 120.0 };
+    std::atomic<int> fxLatency { 0 };
+    bool wasPipelined = false;
+    bool convolutionActive = true;
+    int tracedQualityLevel = 0;
     bool samplesLoaded = false;
 
+    // Last, so its thread has stopped before any FX state it uses goes away.
+    soulbass::FxPipeline fxPipeline;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SoulBassAudioProcessor)
 };
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace soulbass
+{
+    //==============================================================================
+    // 2^x over one octave, tabulated and interpolated linearly; whole octaves are
+    // applied as a power-of-two scale. Accurate to a small fraction of a cent,
+    // with no transcendental call on the audio thread.
+    class Exp2Table
+    {
+    public:
+        static constexpr int resolution = 1024;    // entries per octave
+
+        static const Exp2Table& get()
+        {
+            static const Exp2Table instance;
+            return instance;
+        }
+
+        // 2^(semitones / 12)
+        double semitonesToRatio (double semitones) const noexcept
+        {
+            const auto octaves = semitones / 12.0;
+            const auto whole = std::floor (octaves);
+            const auto position = (octaves - whole) * (double) resolution;
+            const auto index = juce::jlimit (0, resolution - 1, (int) position);
+            const auto frac = position - (double) index;
+
+            const auto value = table[(size_t) index] + frac * (table[(size_t) index + 1] - table[(size_t) index]);
+            return std::ldexp (value, (int) whole);
+        }
+
+    private:
+        Exp2Table()
+        {
+            for (int i = 0; i <= resolution; ++i)
+                table[(size_t) i] = std::exp2 ((double) i / (double) resolution);
+        }
+
+        std::array<double, (size_t) resolution + 1> table {};
+
+        JUCE_DECLARE_NON_COPYABLE (Exp2Table)
+    };
+
+    //==============================================================================
+    // Portamento between notes, in semitones.
+    //
+    // A glide is a straight line in pitch, so a fifth sounds the same speed in any
+    // octave. Its per-sample step is fixed when the note starts: the pitch ratio
+    // then only needs one multiply per sample, by getRatioStep(), for the whole
+    // glide.
+    class Portamento
+    {
+    public:
+        enum class Mode
+        {
+            constantTime = 0,   // every glide takes the glide time
+            constantRate        // the glide time is per octave
+        };
+
+        enum class Direction
+        {
+            up = 0,
+            down,
+            both
+        };
+
+        void setSampleRate (double newSampleRate) noexcept { sampleRate = newSampleRate; }
+
+        // legatoOnly glides only into notes played while the last one is held.
+        void setParameters (bool shouldBeEnabled, Mode newMode, float seconds, Direction newDirection, bool legatoOnlyIn) noexcept
+        {
+            enabled = shouldBeEnabled;
+            mode = newMode;
+            glideSeconds = juce::jmax (0.0f, seconds);
+            direction = newDirection;
+            legatoOnly = legatoOnlyIn;
+        }
+
+        // Sets the next note (in semitones) and returns true if it glides there.
+        // legato says the previous note is still held.
+        bool noteOn (double semitones, bool legato) noexcept
+        {
+            const auto distance = semitones - current;
+            const bool directionAllowed = direction == Direction::both
+                                          || (direction == Direction::up ? distance > 0.0 : distance < 0.0);
+
+            target = semitones;
+            remaining = 0;
+
+            const auto seconds = mode == Mode::constantTime ? (double) glideSeconds
+                                                            : (double) glideSeconds * std::abs (distance) / 12.0;
+            const auto numSamples = juce::roundToInt (seconds * sampleRate);
+
+            if (! enabled || ! hasNote || (legatoOnly && ! legato) || ! directionAllowed || numSamples < 1)
+            {
+                current = target;
+                hasNote = true;
+                return false;
+            }
+
+            remaining = numSamples;
+            step = distance / (double) numSamples;
+            ratioStep = Exp2Table::get().semitonesToRatio (step);
+            return true;
+        }
+
+        // Forgets the last note, so the next one starts in place.
+        void reset() noexcept
+        {
+            hasNote = false;
+            remaining = 0;
+            current = target;
+        }
+
+        bool isGliding() const noexcept { return remaining > 0; }
+        int getRemainingSamples() const noexcept { return remaining; }
+
+        // Per-sample change while gliding, in semitones and as a ratio.
+        double getStep() const noexcept { return isGliding() ? step : 0.0; }
+        double getRatioStep() const noexcept { return isGliding() ? ratioStep : 1.0; }
+
+        double getCurrent() const noexcept { return current; }
+        double getTarget() const noexcept { return target; }
+
+        void advance (int numSamples) noexcept
+        {
+            remaining = juce::jmax (0, remaining - numSamples);
+            current = target - step * (double) remaining;
+        }
+
+    private:
+        double sampleRate = 44100.0;
+        bool enabled = false, legatoOnly = false;
+        Mode mode = Mode::constantTime;
+        Direction direction = Direction::up;
+        float glideSeconds = 0.0f;
+
+        bool hasNote = false;
+        double current = 0.0, target = 0.0;
+        double step = 0.0, ratioStep = 1.0;
+        int remaining = 0;
+    };
+} // namespace soulbass
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "StageProfiler.h"
+
+namespace soulbass
+{
+    //==============================================================================
+    // Hidden developer overlay for the stage profiler. Toggled from the editor with
+    // Cmd/Ctrl+Shift+P; while it is showing, Cmd/Ctrl+Shift+S writes the current
+    // report to Documents/SoulBass Profiles.
+    class ProfilerOverlay : public juce::Component,
+                            private juce::Timer
+    {
+    public:
+        explicit ProfilerOverlay (const StageProfiler& profilerIn)
+            : profiler (profilerIn)
+        {
+            setInterceptsMouseClicks (false, false);
+        }
+
+        void setShowing (bool shouldShow)
+        {
+            setVisible (shouldShow);
+
+            if (shouldShow)
+            {
+                refresh();
+                startTimerHz (4);
+            }
+            else
+            {
+                stopTimer();
+            }
+        }
+
+        juce::File dumpReport()
+        {
+            auto dir = juce::File::getSpecialLocation (juce::File::userDocumentsDirectory).getChildFile ("SoulBass Profiles");
+            dir.createDirectory();
+
+            auto file = dir.getChildFile ("profile-" + juce::Time::getCurrentTime().formatted ("%Y%m%d-%H%M%S") + ".txt");
+
+            if (profiler.writeReport (file))
+                status = "saved " + file.getFullPathName();
+            else
+                status = "could not write " + file.getFullPathName();
+
+            repaint();
+            return file;
+        }
+
+        void paint (juce::Graphics& g) override
+        {
+            g.fillAll (juce::Colour::fromRGB (20, 18, 28).withAlpha (0.9f));
+
+            g.setColour (juce::Colours::white.withAlpha (0.85f));
+            g.setFont (juce::Font (juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain));
+            g.drawMultiLineText (text, 12, 24, getWidth() - 24);
+
+            g.setColour (juce::Colour::fromRGB (100, 200, 230));
+            g.drawText (status.isEmpty() ? juce::String ("Cmd/Ctrl+Shift+S to save report") : status,
+                        12, getHeight() - 24, getWidth() - 24, 14, juce::Justification::left);
+        }
+
+    private:
+        void timerCallback() override { refresh(); }
+
+        void refresh()
+        {
+            text = profiler.getReport().toString();
+            repaint();
+        }
+
+        const StageProfiler& profiler;
+        juce::String text, status;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProfilerOverlay)
+    };
+} // namespace soulbass
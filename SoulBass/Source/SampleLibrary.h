@@ -0,0 +1,174 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BinaryData.h"
+#include "SustainWavetable.h"
+
+namespace soulbass
+{
+    //==============================================================================
+    // Process-wide cache of the decoded BinaryData samples.
+    //
+    // Decoding every sample costs hundreds of megabytes, so all processors in the
+    // process (plugin instances in one host, render workers in soulbass-render)
+    // share the same read-only buffers. The cache only holds weak references: the
+    // memory goes when the last processor using it does.
+    //
+    // A sample that settles into a steady cycle can instead be kept only up to the
+    // end of its attack, with the rest carried by a SustainWavetable. Finding the
+    // cycle is slow, so load() always gives the recording and loadSustained() is
+    // left to a background thread (see SustainLoader).
+    class SampleLibrary
+    {
+    public:
+        struct Sample
+        {
+            std::shared_ptr<const juce::AudioBuffer<float>> data;
+            double sampleRate = 44100.0;
+            std::shared_ptr<const SustainWavetable> sustain;   // null if the sample plays out as recorded
+        };
+
+        // Decodes the named sample on first use; null data if it isn't in BinaryData
+        // or can't be read. Comes with its sustain table if another processor has
+        // already had one built. Thread-safe.
+        static Sample load (const juce::String& fileName)
+        {
+            auto& library = getInstance();
+            const std::lock_guard<std::mutex> lock (library.mutex);
+
+            auto& entry = library.entries[fileName];
+            const auto sustained = entry.getSustained();
+            if (sustained.sustain != nullptr)
+                return sustained;
+
+            if (auto data = entry.data.lock())
+                return { data, entry.sampleRate, {} };
+
+            auto sample = library.decode (fileName);
+            entry.data = sample.data;
+            entry.sampleRate = sample.sampleRate;
+            return sample;
+        }
+
+        // The named sample as its attack and sustain table; null data if it never
+        // settles into a steady cycle. Each sample is analysed once per process, but
+        // that can take a good fraction of a second, so call this from a background
+        // thread. Thread-safe.
+        static Sample loadSustained (const juce::String& fileName)
+        {
+            auto& library = getInstance();
+
+            {
+                const std::lock_guard<std::mutex> lock (library.mutex);
+
+                auto& entry = library.entries[fileName];
+                if (entry.analysed && ! entry.steady)
+                    return {};
+
+                const auto sustained = entry.getSustained();
+                if (sustained.sustain != nullptr)
+                    return sustained;
+            }
+
+            const auto recording = load (fileName);
+            if (recording.data == nullptr || recording.sustain != nullptr)
+                return recording;
+
+            // Unlocked, so other samples can load meanwhile.
+            Sample result;
+            if (auto sustain = SustainWavetable::extract (*recording.data, recording.sampleRate))
+                result = { sustain->makeAttack (*recording.data), recording.sampleRate, std::move (sustain) };
+
+            const std::lock_guard<std::mutex> lock (library.mutex);
+
+            auto& entry = library.entries[fileName];
+            entry.analysed = true;
+            entry.steady = result.sustain != nullptr;
+
+            // Another thread may have got there first; share its buffers.
+            const auto sustained = entry.getSustained();
+            if (sustained.sustain != nullptr)
+                return sustained;
+
+            entry.attack = result.data;
+            entry.sustain = result.sustain;
+            return result;
+        }
+
+    private:
+        struct Entry
+        {
+            Sample getSustained() const
+            {
+                auto table = sustain.lock();
+                auto head = attack.lock();
+                return table != nullptr && head != nullptr ? Sample { head, sampleRate, table } : Sample {};
+            }
+
+            std::weak_ptr<const juce::AudioBuffer<float>> data;     // the full recording
+            double sampleRate = 44100.0;
+            std::weak_ptr<const juce::AudioBuffer<float>> attack;
+            std::weak_ptr<const SustainWavetable> sustain;
+            bool analysed = false, steady = false;
+        };
+
+        SampleLibrary()
+        {
+            formatManager.registerBasicFormats();
+        }
+
+        static SampleLibrary& getInstance()
+        {
+            static SampleLibrary instance;
+            return instance;
+        }
+
+        // Mirror JUCE's BinaryData identifier generation.
+        static juce::String toResourceName (const juce::String& fileName)
+        {
+            juce::String cleaned;
+            for (int i = 0; i < fileName.length(); ++i)
+            {
+                auto c = fileName[i];
+                const bool first = (i == 0);
+                const bool isLetter = juce::CharacterFunctions::isLetter (c);
+                const bool isDigit = juce::CharacterFunctions::isDigit (c);
+                const bool allowed = first ? (isLetter || c == '_') : (isLetter || isDigit || c == '_');
+                cleaned << (allowed ? juce::String::charToString (c) : juce::String ("_"));
+            }
+
+            if (cleaned.isEmpty() || !(juce::CharacterFunctions::isLetter (cleaned[0]) || cleaned[0] == '_'))
+                cleaned = "_" + cleaned;
+
+            return cleaned;
+        }
+
+        Sample decode (const juce::String& fileName)
+        {
+            int dataSize = 0;
+            const auto resourceName = toResourceName (juce::File (fileName).getFileName());
+            const auto* resource = BinaryData::getNamedResource (resourceName.toRawUTF8(), dataSize);
+
+            if (resource == nullptr)
+                return {};
+
+            auto stream = std::make_unique<juce::MemoryInputStream> (resource, (size_t) dataSize, false);
+            auto reader = std::unique_ptr<juce::AudioFormatReader> (formatManager.createReaderFor (std::move (stream)));
+
+            if (reader == nullptr)
+                return {};
+
+            auto length = (int) reader->lengthInSamples;
+            auto buffer = std::make_shared<juce::AudioBuffer<float>> ((int) reader->numChannels, length);
+            reader->read (buffer.get(), 0, length, 0, true, true);
+
+            return { std::move (buffer), reader->sampleRate, {} };
+        }
+
+        std::mutex mutex;
+        juce::AudioFormatManager formatManager;
+        std::map<juce::String, Entry> entries;
+
+        JUCE_DECLARE_NON_COPYABLE (SampleLibrary)
+    };
+} // namespace soulbass
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace soulbass
+{
+    //==============================================================================
+    // 16-tap Blackman-windowed sinc for the offline render profile. The kernel is
+    // tabulated at 256 sub-sample phases and interpolated linearly between them,
+    // so reading a sample costs 16 multiply-adds and no transcendental calls.
+    class SincInterpolator
+    {
+    public:
+        static constexpr int numTaps = 16;
+        static constexpr int numPhases = 256;
+
+        static const SincInterpolator& get()
+        {
+            static const SincInterpolator instance;
+            return instance;
+        }
+
+        // Value of data at pos + alpha (0 <= alpha < 1). Taps outside the buffer
+        // read as silence.
+        float read (const float* data, int length, int pos, float alpha) const noexcept
+        {
+            const auto phase = alpha * (float) numPhases;
+            const auto index = juce::jlimit (0, numPhases - 1, (int) phase);
+            const auto frac = phase - (float) index;
+            const auto& k0 = table[(size_t) index];
+            const auto& k1 = table[(size_t) index + 1];
+
+            const auto first = pos - (numTaps / 2 - 1);
+            float sum = 0.0f;
+
+            if (first >= 0 && first + numTaps <= length)
+            {
+                for (int t = 0; t < numTaps; ++t)
+                    sum += data[first + t] * (k0[(size_t) t] + frac * (k1[(size_t) t] - k0[(size_t) t]));
+            }
+            else
+            {
+                for (int t = juce::jmax (0, -first); t < numTaps && first + t < length; ++t)
+                    sum += data[first + t] * (k0[(size_t) t] + frac * (k1[(size_t) t] - k0[(size_t) t]));
+            }
+
+            return sum;
+        }
+
+    private:
+        SincInterpolator()
+        {
+            const auto halfWidth = (double) numTaps / 2.0;
+
+            for (int p = 0; p <= numPhases; ++p)
+            {
+                const auto offset = (double) p / (double) numPhases;
+                auto& row = table[(size_t) p];
+                double sum = 0.0;
+
+                for (int t = 0; t < numTaps; ++t)
+                {
+                    const auto x = (double) (t - (numTaps / 2 - 1)) - offset;
+                    const auto sinc = std::abs (x) < 1.0e-9 ? 1.0 : std::sin (juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+                    const auto w = juce::MathConstants<double>::pi * x / halfWidth;
+                    const auto window = std::abs (x) >= halfWidth ? 0.0 : 0.42 + 0.5 * std::cos (w) + 0.08 * std::cos (2.0 * w);
+
+                    row[(size_t) t] = (float) (sinc * window);
+                    sum += sinc * window;
+                }
+
+                // Unity gain at DC for every phase.
+                for (auto& k : row)
+                    k = (float) ((double) k / sum);
+            }
+        }
+
+        std::array<std::array<float, (size_t) numTaps>, (size_t) numPhases + 1> table {};
+
+        JUCE_DECLARE_NON_COPYABLE (SincInterpolator)
+    };
+} // namespace soulbass
@@ -1,29 +1,381 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "BlockEnvelope.h"
+#include "ModMatrix.h"
+#include "Portamento.h"
+#include "SincInterpolator.h"
+#include "SubOscillator.h"
+#include "SustainWavetable.h"
+#include "TraceRecorder.h"
+#include "VoiceRenderPool.h"
 
 namespace soulbass
 {
     enum class FilterType
     {
         lowPass = 0,
-        highPass
+        highPass,
+        bandPass,
+        notch,
+        ladder          // four-pole low-pass
     };
 
+    enum class Interpolation
+    {
+        linear = 0,
+        sinc        // offline render profile
+    };
+
+    //==============================================================================
+    // tan (pi * f / sampleRate), the prewarped integrator gain of a TPT filter,
+    // tabulated over normalised frequency and interpolated linearly. A cutoff
+    // change then costs a multiply and a lerp, so sweeping the cutoff is as cheap
+    // as holding it.
+    class CutoffTable
+    {
+    public:
+        static constexpr int size = 1024;                   // entries over f / sampleRate = 0..0.5
+        static constexpr float maxNormalisedFrequency = 0.49f;
+
+        static const CutoffTable& get()
+        {
+            static const CutoffTable instance;
+            return instance;
+        }
+
+        float getGain (float normalisedFrequency) const noexcept
+        {
+            const auto position = juce::jlimit (0.0f, maxNormalisedFrequency, normalisedFrequency) * (float) (2 * size);
+            const auto index = (int) position;
+            const auto frac = position - (float) index;
+            return table[(size_t) index] + frac * (table[(size_t) index + 1] - table[(size_t) index]);
+        }
+
+    private:
+        CutoffTable()
+        {
+            for (int i = 0; i < size; ++i)
+                table[(size_t) i] = (float) std::tan (juce::MathConstants<double>::halfPi * (double) i / (double) size);
+        }
+
+        std::array<float, (size_t) size> table {};
+
+        JUCE_DECLARE_NON_COPYABLE (CutoffTable)
+    };
+
+    //==============================================================================
+    // The voice filter, two channels.
+    //
+    // The multimode responses share one TPT state-variable filter (the same
+    // topology and maths as juce::dsp::StateVariableTPTFilter) and differ only in
+    // how its outputs are mixed; band-pass is normalised to unity at the centre.
+    // The ladder is four TPT one-poles with the feedback loop solved exactly
+    // (zero-delay feedback); resonance 2 takes it to the edge of self-oscillation.
+    // Half the bass the feedback takes away is made up at the input.
+    // Which of the two runs is picked at compile time so the voice's render loops
+    // can be specialised on it.
+    //
+    // State is kept stage by stage with the channels side by side. Each channel
+    // is processed on its own, so a mono voice only pays for the one.
+    class VoiceFilter
+    {
+    public:
+        void setSampleRate (double newSampleRate) noexcept
+        {
+            inverseSampleRate = (float) (1.0 / newSampleRate);
+            frequency = -1.0f;
+        }
+
+        // Switching between the ladder and the state-variable filter clears the
+        // state, which means something different to each.
+        void setType (FilterType newType) noexcept
+        {
+            if (newType == type)
+                return;
+
+            if ((newType == FilterType::ladder) != (type == FilterType::ladder))
+                reset();
+
+            type = newType;
+            update();
+        }
+
+        void setResonance (float newResonance) noexcept
+        {
+            if (newResonance == resonance)
+                return;
+
+            resonance = newResonance;
+            R2 = 1.0f / resonance;
+            k = juce::jlimit (0.0f, 3.95f, (resonance - 0.1f) * 2.1f);
+            update();
+        }
+
+        void setCutoffFrequency (float newFrequency) noexcept
+        {
+            if (newFrequency == frequency)
+                return;
+
+            frequency = newFrequency;
+            g = CutoffTable::get().getGain (frequency * inverseSampleRate);
+            update();
+        }
+
+        void reset() noexcept
+        {
+            for (auto& stage : state)
+                stage = {};
+        }
+
+        template <bool ladder>
+        float processSample (int channel, float input) noexcept
+        {
+            auto& s0 = state[0][(size_t) channel];
+            auto& s1 = state[1][(size_t) channel];
+
+            if constexpr (ladder)
+            {
+                auto& s2 = state[2][(size_t) channel];
+                auto& s3 = state[3][(size_t) channel];
+
+                // The four stages' output if the input were zero, fed back and
+                // solved for the input to the first stage.
+                const auto sigma = (G3 * s0 + G2 * s1 + G * s2 + s3) * onePoleDecay;
+                const auto u = (input * inputGain - k * sigma) * feedbackScale;
+
+                auto v = (u - s0) * G;
+                const auto y0 = v + s0;
+                s0 = y0 + v;
+
+                v = (y0 - s1) * G;
+                const auto y1 = v + s1;
+                s1 = y1 + v;
+
+                v = (y1 - s2) * G;
+                const auto y2 = v + s2;
+                s2 = y2 + v;
+
+                v = (y2 - s3) * G;
+                const auto y3 = v + s3;
+                s3 = y3 + v;
+
+                return y3;
+            }
+            else
+            {
+                const auto yHP = h * (input - s0 * (g + R2) - s1);
+                const auto yBP = yHP * g + s0;
+                s0 = yHP * g + yBP;
+
+                const auto yLP = yBP * g + s1;
+                s1 = yBP * g + yLP;
+
+                return yLP * mixLP + yBP * mixBP + yHP * mixHP;
+            }
+        }
+
+    private:
+        void update() noexcept
+        {
+            h = 1.0f / (1.0f + R2 * g + g * g);
+
+            G = g / (1.0f + g);
+            G2 = G * G;
+            G3 = G2 * G;
+            onePoleDecay = 1.0f / (1.0f + g);
+            feedbackScale = 1.0f / (1.0f + k * G3 * G);
+            inputGain = 1.0f + 0.5f * k;
+
+            mixLP = type == FilterType::lowPass || type == FilterType::notch ? 1.0f : 0.0f;
+            mixHP = type == FilterType::highPass || type == FilterType::notch ? 1.0f : 0.0f;
+            mixBP = type == FilterType::bandPass ? R2 : 0.0f;
+        }
+
+        FilterType type = FilterType::lowPass;
+        float inverseSampleRate = 1.0f / 44100.0f;
+        float frequency = -1.0f, resonance = -1.0f;
+
+        float g = 0.0f, R2 = 1.0f, h = 1.0f;
+        float mixLP = 1.0f, mixBP = 0.0f, mixHP = 0.0f;
+        float k = 0.0f, G = 0.0f, G2 = 0.0f, G3 = 0.0f, onePoleDecay = 1.0f;
+        float feedbackScale = 1.0f, inputGain = 1.0f;
+
+        std::array<std::array<float, 2>, 4> state {};
+    };
+
+    //==============================================================================
+    // Unison: up to eight detuned, panned copies of one note reading the same
+    // sample, under one envelope and one filter.
+    //
+    // The copies are lanes in structure-of-arrays form, so the read-head updates,
+    // interpolation weights and pan gains are plain loops over contiguous arrays
+    // that the compiler vectorises; only the sample fetches themselves are per
+    // lane.
+    class UnisonStack
+    {
+    public:
+        static constexpr int maxVoices = 8;
+
+        // detuneCents is the spread between the outermost lanes; stereoSpread and
+        // phaseRandom are 0..1.
+        void setParameters (int numVoicesIn, float detuneCents, float stereoSpread, float phaseRandomIn) noexcept
+        {
+            numVoicesIn = juce::jlimit (1, maxVoices, numVoicesIn);
+            phaseRandom = juce::jlimit (0.0f, 1.0f, phaseRandomIn);
+
+            if (numVoicesIn == pendingVoices && detuneCents == spreadCents && stereoSpread == spread)
+                return;
+
+            spreadCents = detuneCents;
+            spread = stereoSpread;
+            updateLanes (numVoices);
+
+            // A new lane count needs new start positions; it waits for the next note.
+            pendingVoices = numVoicesIn;
+        }
+
+        bool isActive() const noexcept { return numVoices > 1; }
+
+        // Starts every lane at position, each moved on by a random part of
+        // maxOffset source samples.
+        void start (double position, double maxOffset, juce::Random& random) noexcept
+        {
+            if (pendingVoices != numVoices)
+                updateLanes (pendingVoices);
+
+            for (int k = 0; k < numVoices; ++k)
+                lanePosition[(size_t) k] = position + (k == 0 ? 0.0 : random.nextDouble() * maxOffset * (double) phaseRandom);
+        }
+
+        // Where the furthest lane is, and how much faster than the note the
+        // fastest lane moves.
+        double getLeadPosition() const noexcept
+        {
+            return *std::max_element (lanePosition.begin(), lanePosition.begin() + numVoices);
+        }
+
+        double getMaxDetune() const noexcept { return laneDetune[(size_t) numVoices - 1]; }
+
+        void movePositions (double delta) noexcept
+        {
+            for (int k = 0; k < numVoices; ++k)
+                lanePosition[(size_t) k] += delta;
+        }
+
+        // See SustainWavetable::foldPosition().
+        void foldPositions (const SustainWavetable& sustain, double minimum) noexcept
+        {
+            for (int k = 0; k < numVoices; ++k)
+                lanePosition[(size_t) k] = sustain.foldPosition (lanePosition[(size_t) k], minimum);
+        }
+
+        // Sums the lanes at their current positions. With checkEnd, lanes past the
+        // end of the sample fall silent; returns false once they all have.
+        template <bool useSinc, bool stereoSource, bool checkEnd>
+        bool read (const float* inL, const float* inR, int length, float& outL, float& outR) const noexcept
+        {
+            std::array<int, (size_t) maxVoices> index;
+            std::array<float, (size_t) maxVoices> alpha;
+
+            for (int k = 0; k < numVoices; ++k)
+            {
+                index[(size_t) k] = (int) lanePosition[(size_t) k];
+                alpha[(size_t) k] = (float) (lanePosition[(size_t) k] - (double) index[(size_t) k]);
+            }
+
+            const auto& sinc = SincInterpolator::get();
+            float sumL = 0.0f, sumR = 0.0f;
+            bool anyLeft = ! checkEnd;
+
+            for (int k = 0; k < numVoices; ++k)
+            {
+                const auto pos = index[(size_t) k];
+                const auto a = alpha[(size_t) k];
+
+                if constexpr (checkEnd)
+                {
+                    if (pos >= length - 1)
+                        continue;
+
+                    anyLeft = true;
+                }
+
+                float l, r;
+
+                if constexpr (useSinc)
+                {
+                    l = sinc.read (inL, length, pos, a);
+                    r = stereoSource ? sinc.read (inR, length, pos, a) : l;
+                }
+                else
+                {
+                    l = inL[pos] + a * (inL[pos + 1] - inL[pos]);
+                    r = stereoSource ? inR[pos] + a * (inR[pos + 1] - inR[pos]) : l;
+                }
+
+                sumL += l * laneGainL[(size_t) k];
+                sumR += r * laneGainR[(size_t) k];
+            }
+
+            outL = sumL;
+            outR = sumR;
+            return anyLeft;
+        }
+
+        // Moves every lane on by one sample at the note's ratio.
+        void advance (double ratio) noexcept
+        {
+            for (int k = 0; k < numVoices; ++k)
+                lanePosition[(size_t) k] += ratio * laneDetune[(size_t) k];
+        }
+
+    private:
+        // Lanes sit evenly across the detune and stereo spreads, in ascending pitch,
+        // with equal-power panning and the sum scaled to keep the overall level.
+        void updateLanes (int newNumVoices) noexcept
+        {
+            numVoices = newNumVoices;
+            const auto level = 1.0f / std::sqrt ((float) numVoices);
+
+            for (int k = 0; k < numVoices; ++k)
+            {
+                const auto offset = numVoices > 1 ? 2.0f * (float) k / (float) (numVoices - 1) - 1.0f : 0.0f;
+                const auto angle = (1.0f + offset * spread) * juce::MathConstants<float>::pi * 0.25f;
+
+                laneDetune[(size_t) k] = std::exp2 ((double) (offset * spreadCents * 0.5f) / 1200.0);
+                laneGainL[(size_t) k] = std::cos (angle) * juce::MathConstants<float>::sqrt2 * level;
+                laneGainR[(size_t) k] = std::sin (angle) * juce::MathConstants<float>::sqrt2 * level;
+            }
+        }
+
+        int numVoices = 1, pendingVoices = 1;
+        float spreadCents = 0.0f, spread = 0.0f, phaseRandom = 0.0f;
+
+        std::array<double, (size_t) maxVoices> lanePosition {};
+        std::array<double, (size_t) maxVoices> laneDetune { 1.0 };
+        std::array<float, (size_t) maxVoices> laneGainL { 1.0f }, laneGainR { 1.0f };
+    };
+
+    //==============================================================================
     struct SampleSound : public juce::SynthesiserSound
     {
         SampleSound (juce::String nameIn,
-                     std::unique_ptr<juce::AudioBuffer<float>> dataIn,
+                     std::shared_ptr<const juce::AudioBuffer<float>> dataIn,
                      double sourceSampleRateIn,
                      int midiNoteStartIn,
                      int midiNoteEndIn,
-                     int midiRootNoteIn)
+                     int midiRootNoteIn,
+                     double rootHzIn,
+                     std::shared_ptr<const SustainWavetable> sustainIn = {})
             : name (std::move (nameIn)),
               data (std::move (dataIn)),
+              sustain (std::move (sustainIn)),
               sourceSampleRate (sourceSampleRateIn),
               midiNoteStart (midiNoteStartIn),
               midiNoteEnd (midiNoteEndIn),
-              midiRootNote (midiRootNoteIn)
+              midiRootNote (midiRootNoteIn),
+              rootHz (rootHzIn)
         {
         }
 
@@ -35,11 +387,13 @@ namespace soulbass
         bool appliesToChannel (int /*midiChannel*/) override { return true; }
 
         juce::String name;
-        std::unique_ptr<juce::AudioBuffer<float>> data;
+        std::shared_ptr<const juce::AudioBuffer<float>> data;   // shared, read-only (see SampleLibrary)
+        std::shared_ptr<const SustainWavetable> sustain;        // if set, data is only the attack
         double sourceSampleRate = 44100.0;
         int midiNoteStart = 0;
         int midiNoteEnd = 127;
         int midiRootNote = 60;
+        double rootHz = 261.63;     // fundamental of the recording, played back on midiRootNote
     };
 
     class SampleVoice : public juce::SynthesiserVoice
@@ -55,16 +409,32 @@ namespace soulbass
         void prepare (const juce::dsp::ProcessSpec& spec)
         {
             currentSampleRate = spec.sampleRate;
-            adsr.setSampleRate (currentSampleRate);
-            filter.prepare (spec);
+            envelope.setSampleRate (currentSampleRate);
+            portamento.setSampleRate (currentSampleRate);
+            filter.setSampleRate (spec.sampleRate);
             filter.reset();
             resetLfo();
+
+            // The shared lookup tables are built on first use, so that happens
+            // here rather than on the audio thread.
+            SincInterpolator::get();
+            Exp2Table::get();
+            CutoffTable::get();
+
+            for (auto& channel : continuation)
+                channel.assign ((size_t) continuationLength, 0.0f);
         }
 
-        void setEnvelope (const juce::ADSR::Parameters& params)    { envParams = params; adsr.setParameters (envParams); }
+        void setInterpolation (Interpolation newInterpolation) noexcept { interpolation = newInterpolation; }
+
+        // Samples between LFO and cutoff updates; 1 is per sample.
+        void setControlInterval (int numSamples) noexcept { controlInterval = juce::jmax (1, numSamples); }
+
+        void setEnvelope (const juce::ADSR::Parameters& params)    { envelope.setParameters (params); }
         void setFilter (FilterType typeIn, float cutoffHz, float resonanceIn)
         {
-            filterType = typeIn;
+            requestedFilterType = typeIn;
+            filterType = getNoteFilterType();
             cutoff = cutoffHz;
             resonance = resonanceIn;
             updateFilter();
@@ -78,13 +448,61 @@ namespace soulbass
             lfoSmoothing = juce::jlimit (0.0f, 0.999f, smoothingIn);
         }
 
-        void setModWheel (float wheelValue) { modWheel = juce::jlimit (0.0f, 1.0f, wheelValue); }
+        void setModWheel (float wheelValue)
+        {
+            wheelValue = juce::jlimit (0.0f, 1.0f, wheelValue);
+            if (wheelValue == modWheelTarget)
+                return;
+
+            modWheelTarget = wheelValue;
+            modWheelRemaining = controlRampSamples;
+            modWheelStep = (modWheelTarget - modWheel) / (float) controlRampSamples;
+        }
+
+        // Length of the ramps pitch bend and mod wheel changes are spread over,
+        // normally the controller resolution.
+        void setControlRampLength (int numSamples) noexcept { controlRampSamples = juce::jmax (1, numSamples); }
         void setPitchBendRange (int semitones) { pitchBendRange = semitones; }
-        void setGlide (bool enabled, float timeSeconds, int directionMode)
+        void setGlide (bool enabled, float timeSeconds, Portamento::Direction direction,
+                       Portamento::Mode mode = Portamento::Mode::constantTime, bool legatoOnly = false)
         {
-            glideEnabled = enabled;
-            glideTimeSeconds = juce::jmax (0.0f, timeSeconds);
-            glideDirection = juce::jlimit (0, 1, directionMode);
+            portamento.setParameters (enabled, mode, timeSeconds, direction, legatoOnly);
+        }
+
+        // Set by the CPU governor: the ladder runs as the SVF low-pass, from the
+        // next note so a sounding one keeps its timbre.
+        void setLadderLimited (bool shouldLimit) noexcept { ladderLimited = shouldLimit; }
+
+        // Up to UnisonStack::maxVoices copies of each note; a change in the
+        // count applies from the next note.
+        void setUnison (int numVoices, float detuneCents, float stereoSpread, float phaseRandom) noexcept
+        {
+            unison.setParameters (numVoices, detuneCents, stereoSpread, phaseRandom);
+        }
+
+        // Synthesised sub under the sample, before the filter; level 0 is off.
+        void setSubOscillator (SubOscillator::Waveform waveform, int octavesDown, float level) noexcept
+        {
+            subOscillator.setParameters (waveform, octavesDown, level);
+        }
+
+        // The unison start offsets are drawn from this voice's own generator,
+        // reseeded from prepareToPlay so offline renders repeat exactly.
+        void setRandomSeed (juce::int64 seed) noexcept { random.setSeed (seed); }
+
+        // The matrix a new note is routed through for its first block, before the
+        // processor's block-rate pass has seen it.
+        void setModMatrix (const ModMatrix* matrix) noexcept { modMatrix = matrix; }
+
+        // Set by the synth just before a note starts: whether another key was
+        // still held when it was played.
+        void setNextNoteLegato (bool isLegato) noexcept { nextNoteLegato = isLegato; }
+
+        // Under the synth's lock, before a sound this voice last played is removed.
+        void forgetSound (const SampleSound* sound) noexcept
+        {
+            if (currentSound == sound)
+                currentSound = nullptr;
         }
 
         void setLegato (bool enabled, bool retriggerIn)
@@ -93,48 +511,86 @@ namespace soulbass
             retriggerEnabled = retriggerIn;
         }
 
+        // The voice's own track in the trace is 1 + index.
+        void setTrace (TraceRecorder* recorder, int index)
+        {
+            trace = recorder;
+            traceTrack = 1 + index;
+        }
+
         void startNote (int midiNoteNumber, float velocity, juce::SynthesiserSound* s,
                         int /*currentPitchWheelPosition*/) override
         {
             if (auto* sampleSound = dynamic_cast<SampleSound*> (s))
             {
+                if (trace != nullptr)
+                    trace->record (TraceEventType::noteOn, traceTrack, midiNoteNumber, juce::roundToInt (velocity * 127.0f));
+
                 currentSound = sampleSound;
                 sourceSamplePosition = 0.0;
-                leftGain = velocity;
-                rightGain = velocity;
-                const bool shouldRetrigger = !legatoEnabled || retriggerEnabled || !adsr.isActive();
+                continuationLevel = -1;
+
+                // Unison lanes start up to one cycle of the recording apart.
+                unison.start (0.0, sampleSound->sourceSampleRate / sampleSound->rootHz, random);
+                noteVelocity = velocity;
+
+                const bool legatoNote = nextNoteLegato;
+                nextNoteLegato = false;
+                const bool shouldRetrigger = !legatoEnabled || retriggerEnabled || !envelope.isActive();
 
                 if (shouldRetrigger)
                 {
-                    adsr.reset();
-                    adsr.setSampleRate (getSampleRate());
-                    adsr.setParameters (envParams);
-                    adsr.noteOn();
+                    envelope.reset();
+                    envelope.setSampleRate (getSampleRate());
+                    envelope.noteOn();
                 }
 
-                updatePitchRatio (midiNoteNumber, pitchWheelPosition);
+                // The read-head ratio scales the recording's own fundamental.
+                subOscillator.start (sampleSound->rootHz, sampleSound->sourceSampleRate, shouldRetrigger);
+
+                // Retire the voice once it is below -96 dBFS at this velocity, with
+                // 6 dB to spare for filter resonance.
+                envelope.setFloor (retireLevel / (juce::jmax (velocity, 1.0e-3f) * 2.0f));
+
+                noteLadderLimited = ladderLimited;
+                filterType = getNoteFilterType();
                 resetLfo();
+
+                // The note's own sources (velocity above all) take effect from its
+                // first sample, not from the next block.
+                if (modMatrix != nullptr && modMatrix->isActive())
+                    startModulation (modMatrix->getVoiceModulation (getModSources()));
+
+                updateGains (false);
+
+                portamento.noteOn ((double) midiNoteNumber, legatoNote);
+                bendSemitones = bendTarget = getBendSemitones (pitchWheelPosition) + modPitch;
+                bendRemaining = 0;
+                updatePitchRatio();
                 resetFilterState();
             }
         }
 
         void stopNote (float /*velocity*/, bool allowTailOff) override
         {
+            if (trace != nullptr)
+                trace->record (TraceEventType::noteOff, traceTrack, getCurrentlyPlayingNote(), allowTailOff ? 1 : 0);
+
             if (allowTailOff)
             {
-                adsr.noteOff();
+                envelope.noteOff();
             }
             else
             {
                 clearCurrentNote();
-                adsr.reset();
+                envelope.reset();
             }
         }
 
         void pitchWheelMoved (int newValue) override
         {
             pitchWheelPosition = newValue;
-            updatePitchRatio (getCurrentlyPlayingNote(), pitchWheelPosition);
+            updateBend();
         }
 
         void controllerMoved (int /*controllerNumber*/, int /*newControllerValue*/) override {}
@@ -144,89 +600,432 @@ namespace soulbass
             if (currentSound == nullptr || currentSound->data == nullptr)
                 return;
 
+            TraceRecorder::ScopedSpan traceSpan (trace, TraceEventType::voiceBegin, traceTrack,
+                                                 getCurrentlyPlayingNote(), numSamples);
+
             auto& data = *currentSound->data;
-            const auto* inL = data.getReadPointer (0);
-            const auto* inR = data.getNumChannels() > 1 ? data.getReadPointer (1) : inL;
-            const auto dataLength = data.getNumSamples();
+            const RenderTarget target { data.getReadPointer (0),
+                                        data.getReadPointer (data.getNumChannels() > 1 ? 1 : 0),
+                                        data.getNumSamples(),
+                                        outputBuffer.getWritePointer (0) + startSample,
+                                        outputBuffer.getWritePointer (outputBuffer.getNumChannels() > 1 ? 1 : 0) + startSample };
 
-            auto* outL = outputBuffer.getWritePointer (0);
-            auto* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer (1) : outL;
+            // Each span runs the loop specialised for the voice's state at its start;
+            // a kernel hands back early when that state changes under it.
+            for (int done = 0; done < numSamples && isVoiceActive();)
+                done += renderSpan (target, done, numSamples - done);
+        }
+
+        void aftertouchChanged (int newAftertouchValue) override          { pressure = (float) newAftertouchValue / 127.0f; }
+        void channelPressureChanged (int newChannelPressureValue) override { pressure = (float) newChannelPressureValue / 127.0f; }
 
-            for (int sample = 0; sample < numSamples; ++sample)
+        // This voice's modulation sources, in ModSource order.
+        ModSourceValues getModSources() const noexcept
+        {
+            return { lfoState, envelope.getValue(), noteVelocity, modWheel, pressure,
+                     (float) (pitchWheelPosition - 8192) / 8192.0f };
+        }
+
+        // Block rate: the matrix's output for this voice. Cutoff and resonance
+        // glide across the block; pitch and gain changes ramp over the control
+        // ramp length.
+        void setModulation (const VoiceModulation& mod, int blockSamples) noexcept
+        {
+            if (mod.cutoffFactor != cutoffModTarget || mod.resonanceOffset != resonanceModTarget)
             {
-                auto pos = (int) sourceSamplePosition;
-                auto alpha = (float) (sourceSamplePosition - (double) pos);
-                auto invAlpha = 1.0f - alpha;
+                cutoffModTarget = mod.cutoffFactor;
+                resonanceModTarget = mod.resonanceOffset;
 
-                if (pos >= dataLength - 1)
+                if (isVoiceActive() && blockSamples > 1)
                 {
-                    clearCurrentNote();
-                    break;
+                    filterModRemaining = blockSamples;
+                    cutoffModStep = std::pow (cutoffModTarget / cutoffModFactor, 1.0f / (float) blockSamples);
+                    resonanceModStep = (resonanceModTarget - resonanceMod) / (float) blockSamples;
+                }
+                else
+                {
+                    cutoffModFactor = cutoffModTarget;
+                    resonanceMod = resonanceModTarget;
+                    filterModRemaining = 0;
+                    updateFilter();
+                }
+            }
+
+            if ((double) mod.pitchSemitones != modPitch)
+            {
+                modPitch = (double) mod.pitchSemitones;
+                updateBend();
+            }
+
+            if (mod.ampGain != modAmp || mod.pan != modPan)
+            {
+                modAmp = mod.ampGain;
+                modPan = mod.pan;
+                updateGains (true);
+            }
+        }
+
+        void reset()
+        {
+            envelope.reset();
+            portamento.reset();
+            nextNoteLegato = false;
+            filter.reset();
+            resetLfo();
+        }
+
+    private:
+        //==============================================================================
+        struct RenderTarget
+        {
+            const float* inL;
+            const float* inR;
+            int length;
+            float* outL;
+            float* outR;
+        };
+
+        // Render loop variants. In the common case (steady pitch, LFO idle, envelope
+        // sustaining) the loop is straight-line code with no per-sample tests. Any
+        // other envelope segment, or a gain ramp, is rendered ahead into the gain
+        // runs, and the span ends where the segment does.
+        enum KernelFlags
+        {
+            stereoSource = 1 << 0,
+            sincInterpolation = 1 << 1,
+            ladderFilter = 1 << 2,
+            lfoModulating = 1 << 3,
+            envelopeSustaining = 1 << 4,
+            generalPitch = 1 << 5,      // gliding, bending or near the end of the sample
+            unisonStacked = 1 << 6,
+            subOscillatorOn = 1 << 7,
+            numKernels = 1 << 8
+        };
+
+        using Kernel = int (SampleVoice::*) (const RenderTarget&, int, int);
+
+        template <size_t... flags>
+        static constexpr std::array<Kernel, sizeof... (flags)> makeKernels (std::index_sequence<flags...>)
+        {
+            return { &SampleVoice::renderKernel<(int) flags>... };
+        }
+
+        int renderSpan (const RenderTarget& target, int offset, int numSamples)
+        {
+            static constexpr auto kernels = makeKernels (std::make_index_sequence<(size_t) numKernels>());
+
+            if (! envelope.isActive())
+            {
+                clearCurrentNote();
+                return numSamples;
+            }
+
+            // A moving pitch is a straight line in semitones for as long as both the
+            // glide and the bend ramp last, so its ratio changes by a constant
+            // factor per sample over the span.
+            const bool pitchMoving = portamento.isGliding() || bendRemaining > 0;
+            pitchRatioStep = 1.0;
+
+            if (! pitchMoving)
+            {
+                currentPitchRatio = targetPitchRatio;
+            }
+            else
+            {
+                if (portamento.isGliding())
+                    numSamples = juce::jmin (numSamples, portamento.getRemainingSamples());
+
+                if (bendRemaining > 0)
+                    numSamples = juce::jmin (numSamples, bendRemaining);
+
+                const auto step = portamento.getStep() + (bendRemaining > 0 ? bendStep : 0.0);
+                pitchRatioStep = Exp2Table::get().semitonesToRatio (step);
+            }
+
+            // Past the end of a stored attack the read heads carry on in the
+            // continuation rendered from the sample's sustain table.
+            auto source = target;
+            const bool continuing = currentSound->sustain != nullptr && enterContinuation (source, numSamples, pitchMoving);
+
+            // Samples the (furthest) read head can take at a steady rate before it
+            // gets near the end of the sample (one sample of margin for rounding).
+            const auto stacked = unison.isActive();
+            const auto leadPosition = stacked ? unison.getLeadPosition() : sourceSamplePosition;
+            const auto leadRatio = stacked ? currentPitchRatio * unison.getMaxDetune() : currentPitchRatio;
+            const auto steadySamples = pitchMoving ? 0
+                                                   : (int) juce::jlimit (0.0, (double) numSamples,
+                                                                         std::floor (((double) source.length - 2.0 - leadPosition) / leadRatio));
+
+            const bool modulating = (lfoDepth != 0.0f && modWheel != 0.0f) || modWheelRemaining > 0 || filterModRemaining > 0;
+            if (! modulating)
+            {
+                const auto baseCutoff = getBaseCutoff();
+                if (baseCutoff != lastCutoffModulated)
+                {
+                    lastCutoffModulated = baseCutoff;
+                    filter.setCutoffFrequency (baseCutoff);
                 }
+            }
+
+            int flags = 0;
+            if (source.inR != source.inL)                 flags |= stereoSource;
+            if (interpolation == Interpolation::sinc)     flags |= sincInterpolation;
+            if (filterType == FilterType::ladder)         flags |= ladderFilter;
+            if (modulating)                               flags |= lfoModulating;
+            if (steadySamples == 0)                       flags |= generalPitch;
+            if (stacked)                                  flags |= unisonStacked;
+            if (subOscillator.isActive())                 flags |= subOscillatorOn;
+
+            auto count = steadySamples == 0 ? numSamples : steadySamples;
+
+            if (envelope.getStage() == BlockEnvelope::Stage::sustain && gainRampRemaining == 0)
+            {
+                flags |= envelopeSustaining;
+            }
+            else
+            {
+                count = juce::jmin (count, envelopeRunLength);
+
+                if (envelope.getStage() == BlockEnvelope::Stage::sustain)
+                    std::fill (envelopeRun.begin(), envelopeRun.begin() + count, envelope.getValue());
+                else
+                    count = envelope.render (envelopeRun.data(), count);
+
+                renderGainRuns (count);
+            }
 
-                float sampleL = inL[pos] * invAlpha + inL[pos + 1] * alpha;
-                float sampleR = inR[pos] * invAlpha + inR[pos + 1] * alpha;
+            const auto done = (this->*kernels[(size_t) flags]) (source, offset, count);
 
-                auto env = adsr.getNextSample();
-                auto lfoValue = getNextLfoValue();
+            if (continuing)
+                moveReadHeads (continuationBase);
 
-                auto cutoffMod = juce::jlimit (40.0f, 20000.0f, cutoff * (1.0f + lfoValue * 0.5f));
-                if (cutoffMod != lastCutoffModulated)
+            if (pitchMoving)
+            {
+                portamento.advance (done);
+
+                if (bendRemaining > 0)
                 {
-                    lastCutoffModulated = cutoffMod;
-                    filter.setCutoffFrequency (cutoffMod);
+                    bendRemaining -= done;
+                    bendSemitones = bendRemaining > 0 ? bendTarget - bendStep * (double) bendRemaining : bendTarget;
                 }
 
-                sampleL = filter.processSample (0, sampleL);
-                sampleR = filter.processSample (1, sampleR);
+                // Back on the exact pitch, so rounding in the running ratio never builds up.
+                currentPitchRatio = getPitchRatio (portamento.getCurrent() + bendSemitones);
+            }
 
-                sampleL *= env * leftGain;
-                sampleR *= env * rightGain;
+            if (! envelope.isActive() && isVoiceActive())
+                clearCurrentNote();
 
-                outL[startSample + sample] += sampleL;
-                outR[startSample + sample] += sampleR;
+            return done;
+        }
+
+        template <int flags>
+        int renderKernel (const RenderTarget& target, int offset, int numSamples)
+        {
+            constexpr bool stereo = (flags & stereoSource) != 0;
+            constexpr bool useSinc = (flags & sincInterpolation) != 0;
+            constexpr bool ladder = (flags & ladderFilter) != 0;
+            constexpr bool modulated = (flags & lfoModulating) != 0;
+            constexpr bool steadyEnvelope = (flags & envelopeSustaining) != 0;
+            constexpr bool general = (flags & generalPitch) != 0;
+            constexpr bool stacked = (flags & unisonStacked) != 0;
+            constexpr bool stereoOut = stereo || stacked;
+            constexpr bool withSub = (flags & subOscillatorOn) != 0;
 
-                if (glideEnabled)
+            const auto& sinc = SincInterpolator::get();
+            const auto* inL = target.inL;
+            const auto* inR = target.inR;
+            auto* outL = target.outL + offset;
+            auto* outR = target.outR + offset;
+
+            auto position = sourceSamplePosition;
+            auto ratio = currentPitchRatio;
+            const auto steadyGainL = steadyEnvelope ? envelope.getValue() * leftGain : 0.0f;
+            const auto steadyGainR = steadyEnvelope ? envelope.getValue() * rightGain : 0.0f;
+
+            const auto ratioStep = pitchRatioStep;
+
+            int i = 0;
+            while (i < numSamples)
+            {
+                float sampleL, sampleR;
+
+                if constexpr (stacked)
+                {
+                    if (! unison.read<useSinc, stereo, general> (inL, inR, target.length, sampleL, sampleR))
+                    {
+                        clearCurrentNote();
+                        break;
+                    }
+                }
+                else
                 {
-                    const float alphaGlide = glideTimeSeconds > 0.0f
-                                                 ? (1.0f - std::exp (-1.0f / (float) (glideTimeSeconds * currentSampleRate)))
-                                                 : 1.0f;
+                    const auto pos = (int) position;
+                    const auto alpha = (float) (position - (double) pos);
+                    const auto invAlpha = 1.0f - alpha;
 
-                    const bool allowGlideUp = glideDirection == 0;
-                    const bool allowGlideDown = glideDirection == 1;
-                    const auto delta = targetPitchRatio - currentPitchRatio;
+                    if constexpr (general)
+                    {
+                        if (pos >= target.length - 1)
+                        {
+                            clearCurrentNote();
+                            break;
+                        }
+                    }
 
-                    if ((delta > 0.0 && allowGlideUp) || (delta < 0.0 && allowGlideDown) || (allowGlideUp && allowGlideDown))
-                        currentPitchRatio += delta * juce::jlimit (0.0f, 1.0f, alphaGlide);
+                    if constexpr (useSinc)
+                    {
+                        sampleL = sinc.read (inL, target.length, pos, alpha);
+                        sampleR = stereo ? sinc.read (inR, target.length, pos, alpha) : sampleL;
+                    }
                     else
-                        currentPitchRatio = targetPitchRatio;
+                    {
+                        sampleL = inL[pos] * invAlpha + inL[pos + 1] * alpha;
+                        sampleR = stereo ? inR[pos] * invAlpha + inR[pos + 1] * alpha : sampleL;
+                    }
                 }
-                else
+
+                if constexpr (withSub)
                 {
-                    currentPitchRatio = targetPitchRatio;
+                    const auto sub = subOscillator.getNextSample (ratio);
+                    sampleL += sub;
+                    sampleR += sub;
+                }
+
+                if constexpr (modulated)
+                {
+                    if (--controlCountdown <= 0)
+                    {
+                        controlCountdown = controlInterval;
+                        advanceFilterModulation (controlInterval);
+                        const auto lfoValue = getNextLfoValue (controlInterval);
+                        const auto cutoffMod = juce::jlimit (40.0f, 20000.0f, cutoff * cutoffModFactor * (1.0f + lfoValue * 0.5f));
+
+                        if (cutoffMod != lastCutoffModulated)
+                        {
+                            lastCutoffModulated = cutoffMod;
+                            filter.setCutoffFrequency (cutoffMod);
+                        }
+                    }
                 }
 
-                sourceSamplePosition += currentPitchRatio;
+                // A mono source only needs the one filter channel, unless unison
+                // has spread it.
+                sampleL = filter.processSample<ladder> (0, sampleL);
+                sampleR = stereoOut ? filter.processSample<ladder> (1, sampleR) : sampleL;
 
-                if (! adsr.isActive())
+                if constexpr (steadyEnvelope)
                 {
-                    clearCurrentNote();
-                    break;
+                    outL[i] += sampleL * steadyGainL;
+                    outR[i] += sampleR * steadyGainR;
+                }
+                else
+                {
+                    outL[i] += sampleL * gainRunL[(size_t) i];
+                    outR[i] += sampleR * gainRunR[(size_t) i];
                 }
+
+                if constexpr (general)
+                    ratio *= ratioStep;
+
+                if constexpr (stacked)
+                    unison.advance (ratio);
+                else
+                    position += ratio;
+
+                ++i;
             }
+
+            sourceSamplePosition = position;
+            currentPitchRatio = ratio;
+
+            // An idle LFO still runs, so it picks up in phase when it comes back.
+            if constexpr (! modulated)
+                if (i > 0)
+                    getNextLfoValue (i);
+
+            return i;
         }
 
-        void aftertouchChanged (int /*newAftertouchValue*/) override {}
-        void channelPressureChanged (int /*newChannelPressureValue*/) override {}
+        // Decides whether this span reads the stored attack or the continuation,
+        // capping numSamples so it doesn't read past the end of either. For the
+        // continuation the read heads are folded back to within a period of the
+        // loop start and moved into its coordinates until the span is done.
+        bool enterContinuation (RenderTarget& source, int& numSamples, bool pitchMoving)
+        {
+            const auto& sustain = *currentSound->sustain;
+            const auto loopStart = (double) sustain.getLoopStart();
+            const auto margin = (double) SincInterpolator::numTaps;
+            const auto stacked = unison.isActive();
 
-        void reset()
+            // The fastest any read head moves over the span.
+            auto maxRatio = currentPitchRatio;
+            if (pitchMoving)
+                maxRatio = juce::jmax (maxRatio, getPitchRatio (portamento.getCurrent() + portamento.getStep() * numSamples
+                                                                + bendSemitones + (bendRemaining > 0 ? bendStep * numSamples : 0.0)));
+            if (stacked)
+                maxRatio *= unison.getMaxDetune();
+
+            auto lead = stacked ? unison.getLeadPosition() : sourceSamplePosition;
+
+            if (lead + (double) numSamples * maxRatio + margin < loopStart)
+                return false;
+
+            if (lead < loopStart - (double) continuationPreroll * 0.5)
+            {
+                numSamples = juce::jmax (1, (int) ((loopStart - margin - lead) / maxRatio));
+                return false;
+            }
+
+            continuationBase = loopStart - (double) continuationPreroll;
+
+            if (stacked)
+                unison.foldPositions (sustain, continuationBase + margin);
+            else
+                sourceSamplePosition = sustain.foldPosition (sourceSamplePosition, continuationBase + margin);
+
+            lead = (stacked ? unison.getLeadPosition() : sourceSamplePosition) - continuationBase;
+            numSamples = juce::jmin (numSamples, juce::jmax (1, (int) (((double) continuationLength - margin - lead) / maxRatio)));
+
+            if (const auto level = sustain.getLevel (maxRatio); level != continuationLevel)
+                renderContinuation (level);
+
+            moveReadHeads (-continuationBase);
+
+            source.inL = continuation[0].data();
+            source.inR = sustain.getNumChannels() > 1 ? continuation[1].data() : source.inL;
+            source.length = continuationLength;
+            return true;
+        }
+
+        // The last of the attack, then the table at the given level.
+        void renderContinuation (int level)
         {
-            adsr.reset();
-            filter.reset();
-            resetLfo();
+            const auto& sustain = *currentSound->sustain;
+            const auto start = sustain.getLoopStart() - continuationPreroll;
+
+            for (int ch = 0; ch < sustain.getNumChannels(); ++ch)
+            {
+                auto* dest = continuation[(size_t) ch].data();
+                juce::FloatVectorOperations::copy (dest, currentSound->data->getReadPointer (ch, start), continuationPreroll);
+                sustain.render (ch, level, sustain.getLoopStart(), continuationLength - continuationPreroll, dest + continuationPreroll);
+            }
+
+            continuationLevel = level;
+        }
+
+        void moveReadHeads (double delta) noexcept
+        {
+            sourceSamplePosition += delta;
+            unison.movePositions (delta);
+        }
+
+        FilterType getNoteFilterType() const noexcept
+        {
+            return requestedFilterType == FilterType::ladder && noteLadderLimited ? FilterType::lowPass
+                                                                                  : requestedFilterType;
         }
 
-    private:
         void resetFilterState()
         {
             filter.reset();
@@ -237,68 +1036,204 @@ namespace soulbass
         {
             lfoPhase = 0.0f;
             lfoState = 0.0f;
+            controlCountdown = 0;
+        }
+
+        double getBendSemitones (int wheelPosition) const noexcept
+        {
+            return (wheelPosition - 8192) / 8192.0 * (double) pitchBendRange;
+        }
+
+        // Read-head increment for a pitch in semitones.
+        double getPitchRatio (double semitones) const noexcept
+        {
+            return Exp2Table::get().semitonesToRatio (semitones - (double) currentSound->midiRootNote)
+                     * (currentSound->sourceSampleRate / getSampleRate());
         }
 
-        void updatePitchRatio (int midiNoteNumber, int wheelPosition)
+        void updatePitchRatio()
         {
             if (currentSound == nullptr || currentSound->data == nullptr)
                 return;
 
-            auto pitchBend = (wheelPosition - 8192) / 8192.0; // -1..1
-            auto bendSemitones = pitchBend * (double) pitchBendRange;
-            auto noteDelta = (double) midiNoteNumber + bendSemitones - (double) currentSound->midiRootNote;
-            auto ratio = std::pow (2.0, noteDelta / 12.0);
-            targetPitchRatio = ratio * (currentSound->sourceSampleRate / getSampleRate());
-            if (! glideEnabled)
-                currentPitchRatio = targetPitchRatio;
+            targetPitchRatio = getPitchRatio (portamento.getTarget() + bendTarget);
+            currentPitchRatio = getPitchRatio (portamento.getCurrent() + bendSemitones);
+        }
+
+        // A note's first modulation, applied outright: there is nothing to ramp from.
+        void startModulation (const VoiceModulation& mod) noexcept
+        {
+            cutoffModFactor = cutoffModTarget = mod.cutoffFactor;
+            resonanceMod = resonanceModTarget = mod.resonanceOffset;
+            filterModRemaining = 0;
+            modPitch = (double) mod.pitchSemitones;
+            modAmp = mod.ampGain;
+            modPan = mod.pan;
+        }
+
+        // Control rate: moves cutoff and resonance along their block ramps.
+        void advanceFilterModulation (int numSamples) noexcept
+        {
+            if (filterModRemaining <= 0)
+                return;
+
+            const auto steps = juce::jmin (numSamples, filterModRemaining);
+            filterModRemaining -= steps;
+
+            if (filterModRemaining > 0)
+            {
+                cutoffModFactor *= steps == 1 ? cutoffModStep : std::pow (cutoffModStep, (float) steps);
+                resonanceMod += resonanceModStep * (float) steps;
+            }
+            else
+            {
+                cutoffModFactor = cutoffModTarget;
+                resonanceMod = resonanceModTarget;
+            }
+
+            filter.setResonance (juce::jlimit (0.1f, 2.0f, resonance + resonanceMod));
         }
 
+        // Cutoff with the matrix applied, before the LFO.
+        float getBaseCutoff() const noexcept { return juce::jlimit (40.0f, 20000.0f, cutoff * cutoffModFactor); }
+
         void updateFilter()
         {
-            if (filterType == FilterType::lowPass)
-                filter.setType (juce::dsp::StateVariableTPTFilterType::lowpass);
+            filter.setType (filterType);
+            filter.setResonance (juce::jlimit (0.1f, 2.0f, resonance + resonanceMod));
+            filter.setCutoffFrequency (getBaseCutoff());
+            lastCutoffModulated = getBaseCutoff();
+        }
+
+        // Wheel bend plus matrix pitch, ramped rather than stepped; a glide in
+        // progress carries on underneath it.
+        void updateBend()
+        {
+            bendTarget = getBendSemitones (pitchWheelPosition) + modPitch;
+
+            if (isVoiceActive() && controlRampSamples > 1)
+            {
+                bendRemaining = controlRampSamples;
+                bendStep = (bendTarget - bendSemitones) / (double) controlRampSamples;
+            }
             else
-                filter.setType (juce::dsp::StateVariableTPTFilterType::highpass);
+            {
+                bendSemitones = bendTarget;
+                bendRemaining = 0;
+            }
+
+            updatePitchRatio();
+        }
+
+        // Velocity, matrix amp and equal-power pan (unity at the centre).
+        void updateGains (bool ramp)
+        {
+            const auto angle = (1.0f + modPan) * juce::MathConstants<float>::pi * 0.25f;
+            const auto gain = noteVelocity * modAmp * juce::MathConstants<float>::sqrt2;
+            leftGainTarget = gain * std::cos (angle);
+            rightGainTarget = gain * std::sin (angle);
+
+            if (! ramp || ! isVoiceActive() || controlRampSamples <= 1)
+            {
+                leftGain = leftGainTarget;
+                rightGain = rightGainTarget;
+                gainRampRemaining = 0;
+                return;
+            }
+
+            gainRampRemaining = controlRampSamples;
+            leftGainStep = (leftGainTarget - leftGain) / (float) controlRampSamples;
+            rightGainStep = (rightGainTarget - rightGain) / (float) controlRampSamples;
+        }
+
+        // The envelope run times the voice gains, ramping them where a change is
+        // in progress.
+        void renderGainRuns (int numSamples) noexcept
+        {
+            const auto ramp = juce::jmin (numSamples, gainRampRemaining);
+
+            for (int i = 0; i < ramp; ++i)
+            {
+                leftGain += leftGainStep;
+                rightGain += rightGainStep;
+                gainRunL[(size_t) i] = envelopeRun[(size_t) i] * leftGain;
+                gainRunR[(size_t) i] = envelopeRun[(size_t) i] * rightGain;
+            }
+
+            if (ramp > 0 && (gainRampRemaining -= ramp) == 0)
+            {
+                leftGain = leftGainTarget;
+                rightGain = rightGainTarget;
+            }
 
-            filter.setResonance (resonance);
-            filter.setCutoffFrequency (cutoff);
-            lastCutoffModulated = cutoff;
+            juce::FloatVectorOperations::multiply (gainRunL.data() + ramp, envelopeRun.data() + ramp, leftGain, numSamples - ramp);
+            juce::FloatVectorOperations::multiply (gainRunR.data() + ramp, envelopeRun.data() + ramp, rightGain, numSamples - ramp);
         }
 
-        float getNextLfoValue()
+        // Advances the LFO by numSamples and returns its value there.
+        float getNextLfoValue (int numSamples)
         {
             if (currentSampleRate <= 0.0)
                 return 0.0f;
 
             auto increment = juce::MathConstants<float>::twoPi * lfoRate / (float) currentSampleRate;
-            lfoPhase += increment;
-            if (lfoPhase > juce::MathConstants<float>::twoPi)
+            lfoPhase += increment * (float) numSamples;
+            while (lfoPhase > juce::MathConstants<float>::twoPi)
                 lfoPhase -= juce::MathConstants<float>::twoPi;
 
+            // The one-pole smoother run numSamples times on a held input.
+            const auto smoothing = numSamples == 1 ? lfoSmoothing
+                                                   : 1.0f - std::pow (1.0f - lfoSmoothing, (float) numSamples);
+
+            if (modWheelRemaining > 0)
+            {
+                const auto steps = juce::jmin (numSamples, modWheelRemaining);
+                modWheelRemaining -= steps;
+                modWheel = modWheelRemaining > 0 ? modWheel + modWheelStep * (float) steps : modWheelTarget;
+            }
+
             auto raw = std::sin (lfoPhase + lfoPhaseOffset);
-            lfoState += lfoSmoothing * (raw - lfoState);
+            lfoState += smoothing * (raw - lfoState);
             return lfoState * lfoDepth * modWheel;
         }
 
         double sourceSamplePosition = 0.0;
         double currentPitchRatio = 1.0;
         double targetPitchRatio = 1.0;
+        double pitchRatioStep = 1.0;        // per sample over the current span
         double currentSampleRate = 44100.0;
         int pitchWheelPosition = 8192;
         int pitchBendRange = 12;
-        float glideTimeSeconds = 0.0f;
-        int glideDirection = 0; // 0 up, 1 down
-        bool glideEnabled = false;
+        double bendSemitones = 0.0, bendTarget = 0.0, bendStep = 0.0;
+        int bendRemaining = 0;
+        Portamento portamento;
+        bool nextNoteLegato = false;
         bool legatoEnabled = false;
         bool retriggerEnabled = true;
 
-        float leftGain = 1.0f;
-        float rightGain = 1.0f;
+        float noteVelocity = 1.0f;
+        float leftGain = 1.0f, rightGain = 1.0f;
+        float leftGainTarget = 1.0f, rightGainTarget = 1.0f;
+        float leftGainStep = 0.0f, rightGainStep = 0.0f;
+        int gainRampRemaining = 0;
+        float pressure = 0.0f;
+
+        // Block-rate matrix output (see setModulation).
+        const ModMatrix* modMatrix = nullptr;
+        float cutoffModFactor = 1.0f, resonanceMod = 0.0f;
+        float cutoffModTarget = 1.0f, resonanceModTarget = 0.0f;
+        float cutoffModStep = 1.0f, resonanceModStep = 0.0f;
+        int filterModRemaining = 0;
+        double modPitch = 0.0;
+        float modAmp = 1.0f, modPan = 0.0f;
 
         float cutoff = 1200.0f;
         float lastCutoffModulated = cutoff;
         float resonance = 0.7f;
-        FilterType filterType = FilterType::lowPass;
+        FilterType filterType = FilterType::lowPass;            // in effect for the current note
+        FilterType requestedFilterType = FilterType::lowPass;
+        bool ladderLimited = false, noteLadderLimited = false;
+        Interpolation interpolation = Interpolation::linear;
 
         float lfoRate = 2.0f;
         float lfoDepth = 0.5f;
@@ -306,12 +1241,293 @@ namespace soulbass
         float lfoSmoothing = 0.15f;
         float lfoPhase = 0.0f;
         float lfoState = 0.0f;
-        float modWheel = 0.0f;
+        float modWheel = 0.0f, modWheelTarget = 0.0f, modWheelStep = 0.0f;
+        int modWheelRemaining = 0;
+        int controlRampSamples = 1;
+        int controlInterval = 1;
+        int controlCountdown = 0;
+
+        static constexpr int envelopeRunLength = 128;
+        static constexpr float retireLevel = 1.585e-5f;    // -96 dBFS
+
+        BlockEnvelope envelope;
+        std::array<float, (size_t) envelopeRunLength> envelopeRun {};
+        std::array<float, (size_t) envelopeRunLength> gainRunL {}, gainRunR {};
+        VoiceFilter filter;
+        UnisonStack unison;
 
-        juce::ADSR adsr;
-        juce::ADSR::Parameters envParams;
-        juce::dsp::StateVariableTPTFilter<float> filter;
+        // The attack's last stretch followed by the sustain table, for reading
+        // past the end of a stored attack; see enterContinuation().
+        static constexpr int continuationPreroll = SustainWavetable::minLoopStart;
+        static constexpr int continuationLength = continuationPreroll + SustainWavetable::maxPeriod + 4096;
+        std::array<std::vector<float>, 2> continuation;
+        int continuationLevel = -1;
+        double continuationBase = 0.0;
+
+        SubOscillator subOscillator;
+        juce::Random random { 1 };
 
         SampleSound* currentSound = nullptr;
+
+        TraceRecorder* trace = nullptr;
+        int traceTrack = 1;
+    };
+
+    //==============================================================================
+    // Synthesiser that can render its voices in parallel: each active voice goes
+    // into its own scratch buffer on the worker pool and the buffers are summed
+    // afterwards. Only blocks with enough samples and voices to pay for the
+    // hand-off take that path; everything else renders serially as before.
+    //
+    // The worker threads are only started the first time parallel rendering is
+    // enabled, so an instance that never uses it holds no idle real-time threads.
+    class SoulSynthesiser : public juce::Synthesiser,
+                           private juce::AsyncUpdater
+    {
+    public:
+        static constexpr int minParallelSamples = 128;
+        static constexpr int minParallelVoices = 3;
+
+        void setTrace (TraceRecorder* recorder) { trace = recorder; }
+
+        // Message thread. Allocates scratch for maxVoices voices of maxBlockSize
+        // samples and sets how many threads to use (0 keeps everything serial).
+        // Threads already running are resized; otherwise they wait until parallel
+        // rendering is enabled.
+        void prepareParallelRendering (int numWorkers, int maxVoices, int maxBlockSize)
+        {
+            requestedWorkers = juce::jmax (0, numWorkers);
+
+            if (workersStarted.load())
+            {
+                pool.setNumWorkers (requestedWorkers);
+                workersStarted.store (pool.getNumWorkers() > 0);
+            }
+
+            scratch.clear();
+            for (int i = 0; i < maxVoices; ++i)
+                scratch.add (new juce::AudioBuffer<float> (2, maxBlockSize));
+
+            activeVoices.ensureStorageAllocated (maxVoices);
+        }
+
+        // Audio thread, before rendering. The first time this enables parallel
+        // rendering the workers are started on the message thread; until then
+        // voices keep rendering serially.
+        void setParallelRenderingEnabled (bool shouldBeEnabled) noexcept
+        {
+            parallelEnabled = shouldBeEnabled;
+
+            if (shouldBeEnabled && requestedWorkers > 0 && ! workersStarted.load())
+                triggerAsyncUpdate();
+        }
+
+        // Starts any workers asked for above straight away, for hosts that have no
+        // message loop running (offline renders) and from prepareToPlay.
+        void startPendingWorkers() { handleUpdateNowIfNeeded(); }
+
+        int getNumActiveVoices() const noexcept { return countActiveVoices(); }
+
+        // Audio thread. Caps the number of sounding voices (0 for no cap): new notes
+        // past the cap steal, and held notes past it are released into their tails
+        // rather than cut.
+        void setVoiceLimit (int maxActiveVoices) noexcept
+        {
+            voiceLimit = juce::jmax (0, maxActiveVoices);
+
+            if (voiceLimit == 0)
+                return;
+
+            const juce::ScopedLock sl (lock);
+
+            int held = 0;
+            for (auto* voice : voices)
+                if (voice->isVoiceActive() && voice->isKeyDown())
+                    ++held;
+
+            for (; held > voiceLimit; --held)
+            {
+                juce::SynthesiserVoice* oldest = nullptr;
+
+                for (auto* voice : voices)
+                    if (voice->isVoiceActive() && voice->isKeyDown()
+                        && (oldest == nullptr || voice->wasStartedBefore (*oldest)))
+                        oldest = voice;
+
+                if (oldest == nullptr)
+                    break;
+
+                oldest->setKeyDown (false);
+                stopVoice (oldest, 0.0f, true);
+            }
+        }
+
+        // Keys are tracked here rather than by each voice, so a note is only
+        // legato while a key is physically down, however the voice it lands on
+        // last ended.
+        void noteOn (int midiChannel, int midiNoteNumber, float velocity) override
+        {
+            auto& held = heldKeys[(size_t) juce::jlimit (1, 16, midiChannel) - 1];
+            const bool legato = held.countNumberOfSetBits() > (held[midiNoteNumber] ? 1 : 0);
+            held.setBit (midiNoteNumber);
+
+            for (auto* voice : voices)
+                if (auto* sampleVoice = dynamic_cast<SampleVoice*> (voice))
+                    sampleVoice->setNextNoteLegato (legato);
+
+            juce::Synthesiser::noteOn (midiChannel, midiNoteNumber, velocity);
+        }
+
+        void noteOff (int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff) override
+        {
+            heldKeys[(size_t) juce::jlimit (1, 16, midiChannel) - 1].clearBit (midiNoteNumber);
+            juce::Synthesiser::noteOff (midiChannel, midiNoteNumber, velocity, allowTailOff);
+        }
+
+        void allNotesOff (int midiChannel, bool allowTailOff) override
+        {
+            for (int ch = 1; ch <= 16; ++ch)
+                if (midiChannel <= 0 || midiChannel == ch)
+                    heldKeys[(size_t) ch - 1].clear();
+
+            juce::Synthesiser::allNotesOff (midiChannel, allowTailOff);
+        }
+
+        // Message thread. Swaps the named sample's full recording for its attack
+        // and sustain table. Returns false while a voice is still playing it, to be
+        // retried later; true once swapped, or if there's no such sound.
+        bool setSampleSustain (const juce::String& name,
+                               std::shared_ptr<const juce::AudioBuffer<float>> attack,
+                               std::shared_ptr<const SustainWavetable> sustain)
+        {
+            juce::SynthesiserSound::Ptr old;
+
+            {
+                const juce::ScopedLock sl (lock);
+
+                for (int i = 0; i < sounds.size(); ++i)
+                {
+                    auto* sound = dynamic_cast<SampleSound*> (sounds.getObjectPointerUnchecked (i));
+
+                    if (sound == nullptr || sound->name != name || sound->sustain != nullptr)
+                        continue;
+
+                    for (auto* voice : voices)
+                        if (voice->getCurrentlyPlayingSound() == sound)
+                            return false;
+
+                    for (auto* voice : voices)
+                        if (auto* sampleVoice = dynamic_cast<SampleVoice*> (voice))
+                            sampleVoice->forgetSound (sound);
+
+                    old = sounds[i];
+                    sounds.set (i, new SampleSound (sound->name, std::move (attack), sound->sourceSampleRate,
+                                                    sound->midiNoteStart, sound->midiNoteEnd, sound->midiRootNote,
+                                                    sound->rootHz, std::move (sustain)));
+                    break;
+                }
+            }
+
+            // The recording itself is freed here, off the audio thread and outside the lock.
+            return true;
+        }
+
+    protected:
+        using juce::Synthesiser::renderVoices;
+
+        void renderVoices (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override
+        {
+            activeVoices.clearQuick();
+
+            if (parallelEnabled && workersStarted.load (std::memory_order_acquire) && numSamples >= minParallelSamples
+                && outputAudio.getNumChannels() == 2 && scratch.size() > 0 && numSamples <= scratch[0]->getNumSamples())
+            {
+                for (auto* voice : voices)
+                    if (voice->isVoiceActive() && activeVoices.size() < scratch.size())
+                        activeVoices.add (voice);
+            }
+
+            if (activeVoices.size() < minParallelVoices)
+            {
+                juce::Synthesiser::renderVoices (outputAudio, startSample, numSamples);
+                return;
+            }
+
+            // Any voices that didn't get scratch render here in the usual way.
+            for (auto* voice : voices)
+                if (voice->isVoiceActive() && ! activeVoices.contains (voice))
+                    voice->renderNextBlock (outputAudio, startSample, numSamples);
+
+            pendingSamples = numSamples;
+            pool.run (activeVoices.size(), renderVoiceTask, this);
+
+            for (int i = 0; i < activeVoices.size(); ++i)
+                for (int ch = 0; ch < 2; ++ch)
+                    outputAudio.addFrom (ch, startSample, *scratch.getUnchecked (i), ch, 0, numSamples);
+        }
+
+        juce::SynthesiserVoice* findFreeVoice (juce::SynthesiserSound* soundToPlay,
+                                               int midiChannel,
+                                               int midiNoteNumber,
+                                               bool stealIfNoneAvailable) const override
+        {
+            if (voiceLimit > 0 && countActiveVoices() >= voiceLimit)
+                return stealIfNoneAvailable ? findVoiceToSteal (soundToPlay, midiChannel, midiNoteNumber) : nullptr;
+
+            return juce::Synthesiser::findFreeVoice (soundToPlay, midiChannel, midiNoteNumber, stealIfNoneAvailable);
+        }
+
+        juce::SynthesiserVoice* findVoiceToSteal (juce::SynthesiserSound* soundToPlay,
+                                                  int midiChannel,
+                                                  int midiNoteNumber) const override
+        {
+            auto* voice = juce::Synthesiser::findVoiceToSteal (soundToPlay, midiChannel, midiNoteNumber);
+
+            if (trace != nullptr && voice != nullptr)
+                trace->record (TraceEventType::voiceSteal, 0, voices.indexOf (voice), voice->getCurrentlyPlayingNote());
+
+            return voice;
+        }
+
+    private:
+        void handleAsyncUpdate() override
+        {
+            if (workersStarted.load())
+                return;
+
+            pool.setNumWorkers (requestedWorkers);
+            workersStarted.store (pool.getNumWorkers() > 0, std::memory_order_release);
+        }
+
+        int countActiveVoices() const noexcept
+        {
+            int count = 0;
+            for (auto* voice : voices)
+                if (voice->isVoiceActive())
+                    ++count;
+
+            return count;
+        }
+
+        static void renderVoiceTask (void* context, int index)
+        {
+            auto& synth = *static_cast<SoulSynthesiser*> (context);
+            auto& buffer = *synth.scratch.getUnchecked (index);
+
+            buffer.clear (0, synth.pendingSamples);
+            synth.activeVoices.getUnchecked (index)->renderNextBlock (buffer, 0, synth.pendingSamples);
+        }
+
+        TraceRecorder* trace = nullptr;
+
+        VoiceRenderPool pool;
+        int requestedWorkers = 0;
+        std::atomic<bool> workersStarted { false };
+        juce::OwnedArray<juce::AudioBuffer<float>> scratch;
+        juce::Array<juce::SynthesiserVoice*> activeVoices;
+        int pendingSamples = 0;
+        std::array<juce::BigInteger, 16> heldKeys;     // per MIDI channel
+        bool parallelEnabled = false;
+        int voiceLimit = 0;
     };
 } // namespace soulbass
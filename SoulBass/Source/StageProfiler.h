@@ -0,0 +1,373 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+namespace soulbass
+{
+    //==============================================================================
+    enum class ProfileStage
+    {
+        voices = 0,
+        inputGain,
+        eq,
+        dynamics,
+        shaper,
+        chorus,
+        delay,
+        reverb,
+        outputGain
+    };
+
+    constexpr int numProfileStages = 9;
+
+    inline const char* getProfileStageName (ProfileStage stage)
+    {
+        switch (stage)
+        {
+            case ProfileStage::voices:     return "voices";
+            case ProfileStage::inputGain:  return "input gain";
+            case ProfileStage::eq:         return "eq";
+            case ProfileStage::dynamics:   return "dynamics";
+            case ProfileStage::shaper:     return "shaper";
+            case ProfileStage::chorus:     return "chorus";
+            case ProfileStage::delay:      return "delay";
+            case ProfileStage::reverb:     return "reverb";
+            case ProfileStage::outputGain: return "output gain";
+        }
+
+        return "";
+    }
+
+    // Cheapest monotonic counter the target offers. Its rate is calibrated against
+    // the high resolution clock on the collector thread, never on the audio thread.
+    inline juce::uint64 readCycleCounter() noexcept
+    {
+       #if JUCE_INTEL
+        return (juce::uint64) __rdtsc();
+       #elif JUCE_ARM && JUCE_64BIT && ! JUCE_MSVC
+        juce::uint64 value;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (value));
+        return value;
+       #else
+        return (juce::uint64) juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    //==============================================================================
+    struct ProfileStats
+    {
+        double minUs = 0.0, meanUs = 0.0, p99Us = 0.0, maxUs = 0.0;
+
+        // Proportion of the block deadline (numSamples / sampleRate).
+        double meanLoad = 0.0, p99Load = 0.0, maxLoad = 0.0;
+    };
+
+    struct ProfileReport
+    {
+        std::array<ProfileStats, (size_t) numProfileStages> stages;
+        ProfileStats total;
+
+        int numBlocks = 0;
+        int droppedBlocks = 0;
+        int lastBlockSize = 0;
+        double lastSampleRate = 0.0;
+
+        juce::String toString() const
+        {
+            juce::String text;
+            text << "SoulBass stage profile\n"
+                 << "blocks: " << numBlocks << "  dropped: " << droppedBlocks
+                 << "  last block: " << lastBlockSize << " @ " << lastSampleRate << " Hz\n\n"
+                 << juce::String::formatted ("%-12s %9s %9s %9s %9s %7s %7s %7s\n",
+                                             "stage", "min us", "mean us", "p99 us", "max us", "mean%", "p99%", "max%");
+
+            auto addRow = [&text] (const char* name, const ProfileStats& s)
+            {
+                text << juce::String::formatted ("%-12s %9.2f %9.2f %9.2f %9.2f %7.2f %7.2f %7.2f\n",
+                                                 name, s.minUs, s.meanUs, s.p99Us, s.maxUs,
+                                                 s.meanLoad * 100.0, s.p99Load * 100.0, s.maxLoad * 100.0);
+            };
+
+            for (int s = 0; s < numProfileStages; ++s)
+                addRow (getProfileStageName ((ProfileStage) s), stages[(size_t) s]);
+
+            addRow ("total", total);
+            return text;
+        }
+    };
+
+    //==============================================================================
+    // Per-stage timing of processBlock.
+    //
+    // The audio thread reads a cycle counter between stages and pushes one record
+    // per block into a fixed-size single-producer FIFO; it never locks, allocates
+    // or waits, and if the FIFO is full the block is counted as dropped. A collector
+    // thread converts the records to microseconds and keeps a rolling history that
+    // reports are computed from. When disabled the audio thread cost is one
+    // atomic load per block.
+    class StageProfiler
+    {
+    public:
+        struct BlockRecord
+        {
+            std::array<juce::uint64, (size_t) numProfileStages> cycles;
+            int numSamples;
+            double sampleRate;
+        };
+
+        StageProfiler() : collector (*this) {}
+
+        ~StageProfiler()
+        {
+            collector.stopThread (2000);
+        }
+
+        // Message thread.
+        void setEnabled (bool shouldBeEnabled)
+        {
+            if (shouldBeEnabled == enabled.load())
+                return;
+
+            if (shouldBeEnabled)
+            {
+                // The audio thread may still be pushing a block from before it was
+                // disabled, so discard from the read side rather than resetting.
+                fifo.finishedRead (fifo.getNumReady());
+                clear();
+                collector.startThread();
+            }
+
+            enabled.store (shouldBeEnabled);
+
+            if (! shouldBeEnabled)
+                collector.stopThread (2000);
+        }
+
+        bool isEnabled() const noexcept { return enabled.load (std::memory_order_relaxed); }
+
+        void clear()
+        {
+            const juce::ScopedLock sl (historyLock);
+            historyCount = 0;
+            historyWrite = 0;
+            dropped.store (0);
+        }
+
+        //==============================================================================
+        // Lives on the audio thread's stack for one block. Each mark() charges the
+        // time since the previous mark (or construction) to the given stage.
+        class BlockTimer
+        {
+        public:
+            BlockTimer (StageProfiler& ownerIn, int numSamples, double sampleRate) noexcept
+                : owner (ownerIn), active (ownerIn.isEnabled())
+            {
+                if (! active)
+                    return;
+
+                record.numSamples = numSamples;
+                record.sampleRate = sampleRate;
+                record.cycles.fill (0);
+                last = readCycleCounter();
+            }
+
+            ~BlockTimer()
+            {
+                if (active)
+                    owner.push (record);
+            }
+
+            void mark (ProfileStage stage) noexcept
+            {
+                if (! active)
+                    return;
+
+                const auto now = readCycleCounter();
+                record.cycles[(size_t) stage] += now - last;
+                last = now;
+            }
+
+        private:
+            StageProfiler& owner;
+            const bool active;
+            juce::uint64 last = 0;
+            BlockRecord record {};
+
+            JUCE_DECLARE_NON_COPYABLE (BlockTimer)
+        };
+
+        //==============================================================================
+        ProfileReport getReport() const
+        {
+            ProfileReport report;
+
+            const juce::ScopedLock sl (historyLock);
+
+            report.numBlocks = historyCount;
+            report.droppedBlocks = dropped.load();
+            report.lastBlockSize = lastBlockSize;
+            report.lastSampleRate = lastSampleRate;
+
+            if (historyCount == 0)
+                return report;
+
+            for (int s = 0; s <= numProfileStages; ++s)
+            {
+                auto& stats = s < numProfileStages ? report.stages[(size_t) s] : report.total;
+                summarise (historyUs[(size_t) s], stats.minUs, stats.meanUs, stats.p99Us, stats.maxUs);
+
+                double minLoad;
+                summarise (historyLoad[(size_t) s], minLoad, stats.meanLoad, stats.p99Load, stats.maxLoad);
+            }
+
+            return report;
+        }
+
+        bool writeReport (const juce::File& file) const
+        {
+            return file.replaceWithText (getReport().toString());
+        }
+
+    private:
+        static constexpr int fifoSize = 1024;
+        static constexpr int historySize = 8192;
+
+        void push (const BlockRecord& record) noexcept
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+            if (size1 == 0)
+            {
+                dropped.fetch_add (1, std::memory_order_relaxed);
+                return;
+            }
+
+            records[(size_t) start1] = record;
+            fifo.finishedWrite (1);
+        }
+
+        //==============================================================================
+        class Collector : public juce::Thread
+        {
+        public:
+            explicit Collector (StageProfiler& ownerIn)
+                : juce::Thread ("SoulBass Profiler"), owner (ownerIn)
+            {
+            }
+
+            void run() override
+            {
+                const auto startCycles = readCycleCounter();
+                const auto startTicks = juce::Time::getHighResolutionTicks();
+
+                while (! threadShouldExit())
+                {
+                    wait (100);
+
+                    // The longer the baseline, the better the estimate of the rate.
+                    const auto elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+                    if (elapsed > 0.05)
+                        owner.collect ((double) (readCycleCounter() - startCycles) / elapsed);
+                }
+            }
+
+        private:
+            StageProfiler& owner;
+        };
+
+        void collect (double cyclesPerSecond)
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+            const juce::ScopedLock sl (historyLock);
+
+            auto addRange = [this, cyclesPerSecond] (int start, int size)
+            {
+                for (int i = start; i < start + size; ++i)
+                    addToHistory (records[(size_t) i], cyclesPerSecond);
+            };
+
+            addRange (start1, size1);
+            addRange (start2, size2);
+            fifo.finishedRead (size1 + size2);
+        }
+
+        void addToHistory (const BlockRecord& record, double cyclesPerSecond)
+        {
+            if (historyUs[0].empty())
+            {
+                for (auto& h : historyUs)
+                    h.resize ((size_t) historySize);
+                for (auto& h : historyLoad)
+                    h.resize ((size_t) historySize);
+            }
+
+            const auto deadlineSeconds = (double) record.numSamples / juce::jmax (1.0, record.sampleRate);
+            double totalSeconds = 0.0;
+
+            for (int s = 0; s <= numProfileStages; ++s)
+            {
+                double seconds;
+                if (s < numProfileStages)
+                {
+                    seconds = (double) record.cycles[(size_t) s] / cyclesPerSecond;
+                    totalSeconds += seconds;
+                }
+                else
+                {
+                    seconds = totalSeconds;
+                }
+
+                historyUs[(size_t) s][(size_t) historyWrite] = (float) (seconds * 1.0e6);
+                historyLoad[(size_t) s][(size_t) historyWrite] = (float) (seconds / deadlineSeconds);
+            }
+
+            historyWrite = (historyWrite + 1) % historySize;
+            historyCount = juce::jmin (historyCount + 1, historySize);
+            lastBlockSize = record.numSamples;
+            lastSampleRate = record.sampleRate;
+        }
+
+        void summarise (const std::vector<float>& values, double& min, double& mean, double& p99, double& max) const
+        {
+            scratch.assign (values.begin(), values.begin() + historyCount);
+
+            const auto range = std::minmax_element (scratch.begin(), scratch.end());
+            min = *range.first;
+            max = *range.second;
+            mean = std::accumulate (scratch.begin(), scratch.end(), 0.0) / (double) scratch.size();
+
+            const auto p99Index = (size_t) std::floor (0.99 * (double) (scratch.size() - 1));
+            std::nth_element (scratch.begin(), scratch.begin() + (std::ptrdiff_t) p99Index, scratch.end());
+            p99 = scratch[p99Index];
+        }
+
+        std::atomic<bool> enabled { false };
+        std::atomic<int> dropped { 0 };
+
+        juce::AbstractFifo fifo { fifoSize };
+        std::array<BlockRecord, (size_t) fifoSize> records {};
+
+        juce::CriticalSection historyLock;
+        std::array<std::vector<float>, (size_t) numProfileStages + 1> historyUs, historyLoad;
+        int historyWrite = 0;
+        int historyCount = 0;
+        int lastBlockSize = 0;
+        double lastSampleRate = 0.0;
+        mutable std::vector<float> scratch;
+
+        Collector collector;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StageProfiler)
+    };
+} // namespace soulbass
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace soulbass
+{
+    //==============================================================================
+    // A synthesised sub one or two octaves under a sample voice.
+    //
+    // The phase is driven by the voice's read-head ratio, so the sub follows the
+    // note through glides and bends without a pitch calculation of its own.
+    // Square and saw are band-limited with PolyBLEP, the triangle's corners with
+    // PolyBLAMP; the sine is a corrected parabola. Each is a handful of operations
+    // per sample.
+    class SubOscillator
+    {
+    public:
+        enum class Waveform
+        {
+            sine = 0,
+            triangle,
+            square,
+            saw
+        };
+
+        void setParameters (Waveform newWaveform, int octavesDown, float newLevel) noexcept
+        {
+            waveform = newWaveform;
+            octaveScale = octavesDown >= 2 ? 0.25 : 0.5;
+            level = juce::jlimit (0.0f, 1.0f, newLevel);
+        }
+
+        bool isActive() const noexcept { return level > 0.0f; }
+
+        // rootHz is the fundamental of the recording, made at sourceSampleRate, so
+        // a read-head ratio of 1 sounds at rootHz. A legato note can carry on from
+        // the current phase.
+        void start (double rootHz, double sourceSampleRate, bool resetPhase) noexcept
+        {
+            cyclesPerRatio = rootHz / sourceSampleRate;
+
+            if (resetPhase)
+                phase = 0.0;
+        }
+
+        float getNextSample (double ratio) noexcept
+        {
+            const auto dt = juce::jmin (0.5, ratio * cyclesPerRatio * octaveScale);
+            const auto t = phase;
+
+            phase += dt;
+            if (phase >= 1.0)
+                phase -= 1.0;
+
+            double out = 0.0;
+
+            switch (waveform)
+            {
+                case Waveform::sine:
+                {
+                    // sin (2 pi t) == -sin (pi x) for x in [-1, 1)
+                    const auto x = 2.0 * t - 1.0;
+                    auto y = 4.0 * x * (1.0 - std::abs (x));
+                    y += 0.225 * (y * std::abs (y) - y);
+                    out = -y;
+                    break;
+                }
+
+                case Waveform::triangle:
+                {
+                    // Rises from -1 to 1 over the first half; the slope changes by
+                    // 8 dt per sample at each corner.
+                    out = t < 0.5 ? 4.0 * t - 1.0 : 3.0 - 4.0 * t;
+                    out += 4.0 * dt * (polyBlamp (t, dt) - polyBlamp (wrap (t + 0.5), dt));
+                    break;
+                }
+
+                case Waveform::square:
+                    out = t < 0.5 ? 1.0 : -1.0;
+                    out += polyBlep (t, dt) - polyBlep (wrap (t + 0.5), dt);
+                    break;
+
+                case Waveform::saw:
+                    out = 2.0 * t - 1.0 - polyBlep (t, dt);
+                    break;
+            }
+
+            return (float) out * level;
+        }
+
+    private:
+        static double wrap (double t) noexcept { return t >= 1.0 ? t - 1.0 : t; }
+
+        // Residual of a step of +2 at phase 0, over one sample either side.
+        static double polyBlep (double t, double dt) noexcept
+        {
+            if (t < dt)
+            {
+                t /= dt;
+                return t + t - t * t - 1.0;
+            }
+
+            if (t > 1.0 - dt)
+            {
+                t = (t - 1.0) / dt;
+                return t * t + t + t + 1.0;
+            }
+
+            return 0.0;
+        }
+
+        // Residual of a change of slope of +2 per sample at phase 0: the integral
+        // of the above.
+        static double polyBlamp (double t, double dt) noexcept
+        {
+            if (t < dt)
+            {
+                t = t / dt - 1.0;
+                return -t * t * t / 3.0;
+            }
+
+            if (t > 1.0 - dt)
+            {
+                t = (t - 1.0) / dt + 1.0;
+                return t * t * t / 3.0;
+            }
+
+            return 0.0;
+        }
+
+        Waveform waveform = Waveform::sine;
+        double octaveScale = 0.5;
+        float level = 0.0f;
+
+        double cyclesPerRatio = 0.0;
+        double phase = 0.0;
+    };
+} // namespace soulbass
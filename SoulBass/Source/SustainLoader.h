@@ -0,0 +1,110 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleLibrary.h"
+#include "SoulSampler.h"
+
+namespace soulbass
+{
+    //==============================================================================
+    // Moves the synth's steady samples onto sustain wavetables in the background.
+    //
+    // The sounds are first loaded as recorded, so prepareToPlay never waits on the
+    // pitch analysis. A low-priority thread then asks SampleLibrary for each
+    // sample's attack and table, and a message-thread timer swaps them into the
+    // synth as they arrive, holding back any sample a voice is still playing.
+    // The thread is only started from the timer, so hosts with no message loop
+    // running (the headless tools) keep the full recordings.
+    class SustainLoader : private juce::Thread,
+                          private juce::Timer
+    {
+    public:
+        explicit SustainLoader (SoulSynthesiser& synthIn)
+            : juce::Thread ("SoulBass Sustain Loader"), synth (synthIn)
+        {
+        }
+
+        ~SustainLoader() override
+        {
+            stopTimer();
+            stopThread (10000);
+        }
+
+        // Message thread, once the sounds have been added to the synth.
+        void start (const juce::StringArray& sampleNames)
+        {
+            if (started)
+                return;
+
+            started = true;
+            names = sampleNames;
+            startTimerHz (10);
+        }
+
+    private:
+        struct Result
+        {
+            juce::String name;
+            SampleLibrary::Sample sample;
+        };
+
+        void run() override
+        {
+            for (const auto& name : names)
+            {
+                if (threadShouldExit())
+                    return;
+
+                auto sample = SampleLibrary::loadSustained (name);
+
+                if (sample.sustain != nullptr)
+                {
+                    const juce::ScopedLock sl (resultLock);
+                    results.push_back ({ name, std::move (sample) });
+                }
+            }
+        }
+
+        void timerCallback() override
+        {
+            if (! threadStarted)
+            {
+                threadStarted = true;
+                startThread (juce::Thread::Priority::low);
+            }
+
+            {
+                const juce::ScopedLock sl (resultLock);
+
+                for (auto& result : results)
+                    waiting.push_back (std::move (result));
+
+                results.clear();
+            }
+
+            waiting.erase (std::remove_if (waiting.begin(), waiting.end(), [this] (Result& result)
+                                           {
+                                               return synth.setSampleSustain (result.name, result.sample.data, result.sample.sustain);
+                                           }),
+                           waiting.end());
+
+            if (! isThreadRunning() && waiting.empty())
+            {
+                const juce::ScopedLock sl (resultLock);
+
+                if (results.empty())
+                    stopTimer();
+            }
+        }
+
+        SoulSynthesiser& synth;
+        juce::StringArray names;
+        bool started = false, threadStarted = false;
+
+        juce::CriticalSection resultLock;
+        std::vector<Result> results;    // from the thread, not yet handed to the synth
+        std::vector<Result> waiting;    // message thread: held back by a playing voice
+
+        JUCE_DECLARE_NON_COPYABLE (SustainLoader)
+    };
+} // namespace soulbass
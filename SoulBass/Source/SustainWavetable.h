@@ -0,0 +1,438 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SincInterpolator.h"
+
+namespace soulbass
+{
+    //==============================================================================
+    // The steady part of a held-oscillator sample, as one mip-mapped cycle.
+    //
+    // extract() looks for a stretch of the sample that holds its level, pitch and
+    // waveform, and averages a few of its cycles into a single-cycle table per
+    // channel. Each mip level keeps an octave fewer harmonics, so any transposition
+    // can be played from a level with nothing above the output's Nyquist.
+    //
+    // Playback keeps the recorded attack up to getLoopStart(), crossfaded into the
+    // table over its last stretch (see makeAttack()), and carries on from there
+    // with render() for as long as the note is held. Phase 0 of the table is at a
+    // fixed source position, so a read head can move by whole periods anywhere
+    // past the loop start without a seam.
+    class SustainWavetable
+    {
+    public:
+        static constexpr int tableSize = 2048;
+        static constexpr int maxPeriod = tableSize;     // longest cycle, in source samples
+        static constexpr int minLoopStart = maxPeriod;  // so a player can keep this much attack in front
+
+        // Null unless the sample settles into a steady cycle. Runs at load time.
+        static std::shared_ptr<const SustainWavetable> extract (const juce::AudioBuffer<float>& sample, double sampleRate)
+        {
+            const auto numChannels = juce::jmin (2, sample.getNumChannels());
+            const auto length = sample.getNumSamples();
+
+            if (numChannels == 0 || length < (int) (sampleRate * minSteadySeconds))
+                return {};
+
+            // The analysis runs on the channels' mix.
+            std::vector<float> mix ((size_t) length, 0.0f);
+            for (int ch = 0; ch < numChannels; ++ch)
+                juce::FloatVectorOperations::addWithMultiply (mix.data(), sample.getReadPointer (ch), 1.0f / (float) numChannels, length);
+
+            // A steady level can still be settling in timbre at first, so the
+            // period search steps further in while enough of it is left.
+            auto region = findSteadyRegion (mix);
+            auto period = 0.0;
+
+            while (region.getLength() >= (int) (sampleRate * minSteadySeconds)
+                    && (period = findPeriod (mix, region)) <= 0.0)
+                region.setStart (region.getStart() + (int) (sampleRate * retrySeconds));
+
+            if (period <= 0.0)
+                return {};
+
+            // The table starts a little way into the steady part, and the attack
+            // fades into it over a few cycles.
+            const auto tableStart = region.getStart() + juce::jmax ((int) (sampleRate * settleSeconds), minLoopStart);
+            const auto crossfade = juce::jmax ((int) (sampleRate * crossfadeSeconds), (int) std::ceil (4.0 * period));
+            const auto loopStart = tableStart + crossfade;
+
+            if (loopStart + (int) std::ceil ((double) averagedCycles * period) + SincInterpolator::numTaps >= region.getEnd())
+                return {};
+
+            std::shared_ptr<SustainWavetable> table (new SustainWavetable (numChannels, period, tableStart, loopStart));
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                table->buildLevels (ch, sample.getReadPointer (ch), length);
+
+            return table;
+        }
+
+        int getNumChannels() const noexcept { return numChannels; }
+        int getNumLevels() const noexcept   { return numLevels; }
+
+        // Source samples per cycle.
+        double getPeriod() const noexcept { return period; }
+
+        // Where the stored attack ends and render() takes over.
+        int getLoopStart() const noexcept { return loopStart; }
+
+        // The level to play at `ratio` source samples per output sample: the
+        // first with no harmonic above the output's Nyquist.
+        int getLevel (double ratio) const noexcept
+        {
+            const auto highestAllowed = 0.5 * period / juce::jmax (ratio, 1.0e-6);
+
+            for (int level = 0; level < numLevels; ++level)
+                if ((double) (topHarmonic >> level) <= highestAllowed)
+                    return level;
+
+            return numLevels - 1;
+        }
+
+        // The table at source positions start, start + 1, ...
+        void render (int channel, int level, int start, int numSamples, float* dest) const noexcept
+        {
+            const auto* table = getTable (channel, level);
+            const auto increment = 1.0 / period;
+
+            auto phase = ((double) start - (double) origin) * increment;
+            phase -= std::floor (phase);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto position = phase * (double) tableSize;
+                const auto index = (int) position;
+                const auto frac = (float) (position - (double) index);
+                dest[i] = table[index] + frac * (table[index + 1] - table[index]);
+
+                phase += increment;
+                if (phase >= 1.0)
+                    phase -= 1.0;
+            }
+        }
+
+        // A read position moved by whole periods to be at or after minimum and,
+        // past the loop start, less than a period beyond it. Past the loop start
+        // the table repeats exactly, so that changes nothing that is heard; a
+        // position behind minimum skips forward within the steady part.
+        double foldPosition (double position, double minimum) const noexcept
+        {
+            const auto start = (double) loopStart;
+
+            if (position >= start + period)
+                return position - period * std::floor ((position - start) / period);
+
+            if (position < minimum)
+                return position + period * std::ceil ((minimum - position) / period);
+
+            return position;
+        }
+
+        // The part of the sample playback keeps: everything before the loop
+        // start, with the stretch from the table's start faded into the table.
+        std::shared_ptr<const juce::AudioBuffer<float>> makeAttack (const juce::AudioBuffer<float>& sample) const
+        {
+            auto attack = std::make_shared<juce::AudioBuffer<float>> (sample.getNumChannels(), loopStart);
+            const auto crossfade = loopStart - origin;
+            std::vector<float> tail ((size_t) crossfade);
+
+            for (int ch = 0; ch < sample.getNumChannels(); ++ch)
+            {
+                attack->copyFrom (ch, 0, sample.getReadPointer (ch), loopStart);
+
+                render (juce::jmin (ch, numChannels - 1), 0, origin, crossfade, tail.data());
+                auto* dest = attack->getWritePointer (ch, origin);
+
+                for (int i = 0; i < crossfade; ++i)
+                {
+                    const auto fade = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::pi * (float) i / (float) crossfade);
+                    dest[i] += fade * (tail[(size_t) i] - dest[i]);
+                }
+            }
+
+            return attack;
+        }
+
+    private:
+        static constexpr int analysisHop = 1024;
+        static constexpr int levelHops = 4;
+        static constexpr double minSteadySeconds = 2.0;
+        static constexpr double retrySeconds = 0.5;
+        static constexpr double settleSeconds = 0.05;
+        static constexpr double crossfadeSeconds = 0.05;
+        static constexpr float maxLevelSwingDb = 1.5f;
+        static constexpr float minLevelDb = -50.0f;
+        static constexpr double periodThreshold = 0.1;      // YIN's dip threshold
+        static constexpr double minCorrelation = 0.99;      // between cycles across the steady part
+        static constexpr double maxDriftCents = 5.0;
+        static constexpr int trackCycles = 8;               // between matches
+        static constexpr int trackRange = 4;                // search either side of a match, in samples
+        static constexpr int averagedCycles = 8;
+
+        SustainWavetable (int numChannelsIn, double periodIn, int originIn, int loopStartIn)
+            : numChannels (numChannelsIn), period (periodIn), origin (originIn), loopStart (loopStartIn)
+        {
+            topHarmonic = juce::jmin (tableSize / 2 - 1, (int) (period * 0.5));
+
+            numLevels = 1;
+            while ((topHarmonic >> numLevels) >= 1)
+                ++numLevels;
+
+            tables.resize ((size_t) (numChannels * numLevels * (tableSize + 1)));
+        }
+
+        const float* getTable (int channel, int level) const noexcept
+        {
+            return tables.data() + (size_t) ((channel * numLevels + level) * (tableSize + 1));
+        }
+
+        float* getTable (int channel, int level) noexcept
+        {
+            return tables.data() + (size_t) ((channel * numLevels + level) * (tableSize + 1));
+        }
+
+        // The longest run of analysis hops whose level stays within a small
+        // swing, ignoring anything near silence. Each hop's level is measured
+        // over the next few hops too, so a low note's cycles don't ripple it.
+        static juce::Range<int> findSteadyRegion (const std::vector<float>& mix)
+        {
+            const auto numHops = (int) mix.size() / analysisHop - (levelHops - 1);
+
+            if (numHops <= 0)
+                return {};
+
+            std::vector<double> sums ((size_t) (numHops + levelHops - 1));
+
+            for (size_t h = 0; h < sums.size(); ++h)
+            {
+                const auto* x = mix.data() + h * analysisHop;
+
+                for (int i = 0; i < analysisHop; ++i)
+                    sums[h] += (double) x[i] * (double) x[i];
+            }
+
+            std::vector<float> levels ((size_t) numHops);
+
+            for (int h = 0; h < numHops; ++h)
+            {
+                const auto sum = std::accumulate (sums.begin() + h, sums.begin() + h + levelHops, 0.0);
+                levels[(size_t) h] = juce::Decibels::gainToDecibels ((float) std::sqrt (sum / (levelHops * analysisHop)), -200.0f);
+            }
+
+            int bestStart = 0, bestLength = 0;
+
+            for (int start = 0; start < numHops; ++start)
+            {
+                auto low = levels[(size_t) start], high = low;
+                int end = start;
+
+                while (end < numHops && low >= minLevelDb && high - low <= maxLevelSwingDb)
+                {
+                    ++end;
+
+                    if (end < numHops)
+                    {
+                        low = juce::jmin (low, levels[(size_t) end]);
+                        high = juce::jmax (high, levels[(size_t) end]);
+                    }
+                }
+
+                if (end - start > bestLength)
+                {
+                    bestStart = start;
+                    bestLength = end - start;
+                }
+
+                // Nothing starting later in this run can be longer.
+                if (bestLength >= numHops - start)
+                    break;
+            }
+
+            return { bestStart * analysisHop, (bestStart + bestLength) * analysisHop };
+        }
+
+        // The period at the start of the region, in source samples, or 0 if the
+        // region doesn't hold it. A first estimate from YIN is refined by matching
+        // a reference cycle against ones 1, 2, 4, ... periods on. The reference is
+        // then followed through the rest of the region: each match has to be
+        // near-perfect and within a few cents of the period, which lets an analog
+        // oscillator's slight drift through but rules out beating, PWM, sync
+        // sweeps and moving filters.
+        static double findPeriod (const std::vector<float>& mix, juce::Range<int> region)
+        {
+            const auto* x = mix.data();
+            const auto start = region.getStart() + analysisHop;
+            const auto window = maxPeriod;
+
+            if (start + window + maxPeriod + 1 >= region.getEnd())
+                return 0.0;
+
+            // YIN: the cumulative-mean-normalised difference function.
+            std::vector<double> difference ((size_t) maxPeriod + 1, 0.0);
+            double runningSum = 0.0;
+            int lag = 0;
+
+            for (int tau = 1; tau <= maxPeriod; ++tau)
+            {
+                double d = 0.0;
+                for (int i = 0; i < window; ++i)
+                {
+                    const auto delta = (double) x[start + i] - (double) x[start + i + tau];
+                    d += delta * delta;
+                }
+
+                difference[(size_t) tau] = d;
+                runningSum += d;
+
+                if (lag == 0 && tau > 2 && runningSum > 0.0 && d * tau / runningSum < periodThreshold)
+                    lag = tau;
+            }
+
+            if (lag == 0)
+                return 0.0;
+
+            while (lag < maxPeriod && difference[(size_t) lag + 1] < difference[(size_t) lag])
+                ++lag;
+
+            auto period = (double) lag;
+            if (lag < maxPeriod)
+                period += parabolicPeak (-difference[(size_t) lag - 1], -difference[(size_t) lag], -difference[(size_t) lag + 1]).offset;
+
+            const auto span = juce::jmax (analysisHop, (int) std::ceil (2.0 * period));
+            const auto last = region.getEnd() - span - trackRange;
+
+            for (int cycles = 1; cycles <= trackCycles; cycles *= 2)
+            {
+                const auto match = findMatch (x, start, span, (double) cycles * period, last);
+                if (match.correlation < minCorrelation)
+                    return 0.0;
+
+                period = match.lag / (double) cycles;
+            }
+
+            double previous = (double) trackCycles * period;
+
+            for (auto predicted = previous + (double) trackCycles * period;; predicted += (double) trackCycles * period)
+            {
+                const auto match = findMatch (x, start, span, predicted, last);
+                if (match.correlation < 0.0)
+                    break;
+
+                const auto localPeriod = (match.lag - previous) / (double) trackCycles;
+
+                if (match.correlation < minCorrelation
+                    || std::abs (1200.0 * std::log2 (localPeriod / period)) > maxDriftCents)
+                    return 0.0;
+
+                predicted = previous = match.lag;
+            }
+
+            return period > 2.0 && period <= (double) maxPeriod ? period : 0.0;
+        }
+
+        struct Match
+        {
+            double lag = 0.0;
+            double correlation = -1.0;   // -1 if the search ran past the end
+        };
+
+        // The lag near `predicted` at which the span from `start` repeats best.
+        static Match findMatch (const float* x, int start, int span, double predicted, int last) noexcept
+        {
+            const auto centre = juce::roundToInt (predicted);
+            if (start + centre + trackRange > last)
+                return {};
+
+            std::array<double, 2 * trackRange + 1> correlation {};
+            for (int offset = -trackRange; offset <= trackRange; ++offset)
+                correlation[(size_t) (offset + trackRange)] = getCorrelation (x + start, x + start + centre + offset, span);
+
+            const auto best = (int) (std::max_element (correlation.begin() + 1, correlation.end() - 1) - correlation.begin());
+            const auto peak = parabolicPeak (correlation[(size_t) best - 1], correlation[(size_t) best], correlation[(size_t) best + 1]);
+
+            return { (double) (centre + best - trackRange) + peak.offset, peak.value };
+        }
+
+        static double getCorrelation (const float* a, const float* b, int length) noexcept
+        {
+            double ab = 0.0, aa = 0.0, bb = 0.0;
+
+            for (int i = 0; i < length; ++i)
+            {
+                ab += (double) a[i] * (double) b[i];
+                aa += (double) a[i] * (double) a[i];
+                bb += (double) b[i] * (double) b[i];
+            }
+
+            return aa > 0.0 && bb > 0.0 ? ab / std::sqrt (aa * bb) : 0.0;
+        }
+
+        struct Peak
+        {
+            double offset = 0.0;    // -0.5..0.5
+            double value = 0.0;
+        };
+
+        // The vertex of the parabola through three equally spaced points.
+        static Peak parabolicPeak (double left, double centre, double right) noexcept
+        {
+            const auto curvature = left - 2.0 * centre + right;
+            if (curvature >= 0.0)
+                return { 0.0, centre };
+
+            const auto offset = juce::jlimit (-0.5, 0.5, 0.5 * (left - right) / curvature);
+            return { offset, centre - 0.25 * (left - right) * offset };
+        }
+
+        // Averages cycles from the table's start, resampled to the table size,
+        // then keeps an octave fewer harmonics at each level.
+        void buildLevels (int channel, const float* data, int length)
+        {
+            const auto& sinc = SincInterpolator::get();
+            const auto step = period / (double) tableSize;
+
+            std::vector<float> spectrum (2 * (size_t) tableSize, 0.0f);
+
+            for (int k = 0; k < averagedCycles; ++k)
+            {
+                for (int i = 0; i < tableSize; ++i)
+                {
+                    const auto position = (double) origin + (double) k * period + (double) i * step;
+                    const auto index = (int) position;
+                    spectrum[(size_t) i] += sinc.read (data, length, index, (float) (position - (double) index)) / (float) averagedCycles;
+                }
+            }
+
+            juce::dsp::FFT fft (juce::roundToInt (std::log2 ((double) tableSize)));
+            fft.performRealOnlyForwardTransform (spectrum.data(), true);
+
+            std::vector<float> levelSpectrum (2 * (size_t) tableSize);
+
+            for (int level = 0; level < numLevels; ++level)
+            {
+                const auto highest = topHarmonic >> level;
+
+                std::fill (levelSpectrum.begin(), levelSpectrum.end(), 0.0f);
+                std::copy (spectrum.begin(), spectrum.begin() + 2 * (highest + 1), levelSpectrum.begin());
+
+                fft.performRealOnlyInverseTransform (levelSpectrum.data());
+
+                auto* table = getTable (channel, level);
+                std::copy (levelSpectrum.begin(), levelSpectrum.begin() + tableSize, table);
+                table[tableSize] = table[0];
+            }
+        }
+
+        int numChannels = 1;
+        double period = 0.0;
+        int origin = 0;         // source position of the table's phase 0
+        int loopStart = 0;
+        int topHarmonic = 1;
+        int numLevels = 1;
+
+        std::vector<float> tables;
+
+        JUCE_DECLARE_NON_COPYABLE (SustainWavetable)
+    };
+} // namespace soulbass
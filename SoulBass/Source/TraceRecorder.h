@@ -0,0 +1,347 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "FxChain.h"
+
+namespace soulbass
+{
+    //==============================================================================
+    enum class TraceEventType : juce::uint8
+    {
+        blockBegin = 0,
+        blockEnd,
+        voiceBegin,
+        voiceEnd,
+        noteOn,
+        noteOff,
+        voiceSteal,
+        parameterBurst,
+        sampleMiss,
+        fxBypass,
+        qualityStep
+    };
+
+    struct TraceEvent
+    {
+        juce::int64 ticks;
+        TraceEventType type;
+        juce::int16 track;      // 0 is processBlock, 1 + n is voice n
+        juce::int32 arg0, arg1;
+    };
+
+    //==============================================================================
+    // Opt-in event recorder that writes Chrome Trace Event JSON (loads in Perfetto
+    // or chrome://tracing).
+    //
+    // record() may be called from any thread, including several at once: events go
+    // into a preallocated bounded queue where producers claim slots with a single
+    // compare-and-swap and never block. A full queue drops the event and counts it.
+    // A writer thread drains the queue every 20 ms and streams JSON to disk; nothing
+    // is formatted or written on the audio thread.
+    class TraceRecorder
+    {
+    public:
+        static constexpr int capacity = 16384;
+
+        TraceRecorder()
+            : slots (new Slot[(size_t) capacity]), writer (*this)
+        {
+            for (int i = 0; i < capacity; ++i)
+                slots[(size_t) i].sequence.store ((juce::uint64) i, std::memory_order_relaxed);
+        }
+
+        ~TraceRecorder()
+        {
+            stop();
+            detachParameters();
+        }
+
+        //==============================================================================
+        // Message thread.
+        bool start (const juce::File& file)
+        {
+            if (isRecording())
+                return false;
+
+            if (file.getParentDirectory().createDirectory().failed())
+                return false;
+
+            outputFile = file;
+            startTicks = juce::Time::getHighResolutionTicks();
+            dropped.store (0);
+            parameterChanges.store (0);
+
+            // Anything that slipped in after the last stop belongs to that session.
+            for (TraceEvent stale; pop (stale);) {}
+
+            writer.startThread();
+            recording.store (true);
+            return true;
+        }
+
+        void stop()
+        {
+            recording.store (false);
+            writer.stopThread (2000);
+        }
+
+        bool isRecording() const noexcept    { return recording.load (std::memory_order_relaxed); }
+        int getNumDropped() const noexcept   { return dropped.load(); }
+        juce::File getFile() const           { return outputFile; }
+
+        // Counts every parameter change so bursts can be reported per block.
+        void attachParameters (juce::AudioProcessor& processor)
+        {
+            detachParameters();
+            parameters = processor.getParameters();
+
+            for (auto* p : parameters)
+                p->addListener (&parameterCounter);
+        }
+
+        //==============================================================================
+        // Any thread.
+        void record (TraceEventType type, int track = 0, int arg0 = 0, int arg1 = 0) noexcept
+        {
+            if (! isRecording())
+                return;
+
+            auto position = writePosition.load (std::memory_order_relaxed);
+
+            for (;;)
+            {
+                auto& slot = slots[(size_t) (position & mask)];
+                const auto sequence = slot.sequence.load (std::memory_order_acquire);
+                const auto difference = (juce::int64) (sequence - position);
+
+                if (difference == 0)
+                {
+                    if (writePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+                    {
+                        slot.event = { juce::Time::getHighResolutionTicks(), type, (juce::int16) track, arg0, arg1 };
+                        slot.sequence.store (position + 1, std::memory_order_release);
+                        return;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    dropped.fetch_add (1, std::memory_order_relaxed);
+                    return;
+                }
+                else
+                {
+                    position = writePosition.load (std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Audio thread, once per block: reports parameter changes since the last call.
+        void flushParameterChanges() noexcept
+        {
+            if (const auto count = parameterChanges.exchange (0, std::memory_order_relaxed); count > 0)
+                record (TraceEventType::parameterBurst, 0, count);
+        }
+
+        //==============================================================================
+        // Brackets a span with a begin event and the matching end event.
+        class ScopedSpan
+        {
+        public:
+            ScopedSpan (TraceRecorder* ownerIn, TraceEventType beginType, int trackIn, int arg0 = 0, int arg1 = 0) noexcept
+                : owner (ownerIn != nullptr && ownerIn->isRecording() ? ownerIn : nullptr),
+                  endType ((TraceEventType) ((int) beginType + 1)),
+                  track (trackIn)
+            {
+                if (owner != nullptr)
+                    owner->record (beginType, track, arg0, arg1);
+            }
+
+            ~ScopedSpan()
+            {
+                if (owner != nullptr)
+                    owner->record (endType, track);
+            }
+
+        private:
+            TraceRecorder* owner;
+            TraceEventType endType;
+            int track;
+
+            JUCE_DECLARE_NON_COPYABLE (ScopedSpan)
+        };
+
+    private:
+        static constexpr juce::uint64 mask = (juce::uint64) capacity - 1;
+        static_assert ((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+        struct Slot
+        {
+            std::atomic<juce::uint64> sequence { 0 };
+            TraceEvent event {};
+        };
+
+        bool pop (TraceEvent& result) noexcept
+        {
+            auto& slot = slots[(size_t) (readPosition & mask)];
+
+            if (slot.sequence.load (std::memory_order_acquire) != readPosition + 1)
+                return false;
+
+            result = slot.event;
+            slot.sequence.store (readPosition + (juce::uint64) capacity, std::memory_order_release);
+            ++readPosition;
+            return true;
+        }
+
+        void detachParameters()
+        {
+            for (auto* p : parameters)
+                p->removeListener (&parameterCounter);
+
+            parameters.clear();
+        }
+
+        //==============================================================================
+        struct ParameterCounter : public juce::AudioProcessorParameter::Listener
+        {
+            explicit ParameterCounter (TraceRecorder& ownerIn) : owner (ownerIn) {}
+
+            void parameterValueChanged (int, float) override
+            {
+                if (owner.isRecording())
+                    owner.parameterChanges.fetch_add (1, std::memory_order_relaxed);
+            }
+
+            void parameterGestureChanged (int, bool) override {}
+
+            TraceRecorder& owner;
+        };
+
+        //==============================================================================
+        class Writer : public juce::Thread
+        {
+        public:
+            explicit Writer (TraceRecorder& ownerIn)
+                : juce::Thread ("SoulBass Trace Writer"), owner (ownerIn)
+            {
+            }
+
+            void run() override
+            {
+                juce::FileOutputStream stream (owner.outputFile);
+                if (! stream.openedOk())
+                    return;
+
+                stream.setPosition (0);
+                stream.truncate();
+                stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+                writeTrackNames (stream);
+
+                while (! threadShouldExit())
+                {
+                    drain (stream);
+                    wait (20);
+                }
+
+                drain (stream);
+                stream << "\n]}\n";
+                stream.flush();
+            }
+
+        private:
+            void writeTrackNames (juce::OutputStream& stream)
+            {
+                constexpr int maxNamedVoices = 16;
+
+                for (int track = 0; track <= maxNamedVoices; ++track)
+                {
+                    const auto name = track == 0 ? juce::String ("processBlock") : "SampleVoice " + juce::String (track - 1);
+                    stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track
+                           << ",\"args\":{\"name\":\"" << name << "\"}},\n"
+                           << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track
+                           << ",\"args\":{\"sort_index\":" << track << "}}";
+
+                    if (track < maxNamedVoices)
+                        stream << ",\n";
+                }
+            }
+
+            void drain (juce::OutputStream& stream)
+            {
+                const auto ticksPerMicrosecond = (double) juce::Time::getHighResolutionTicksPerSecond() * 1.0e-6;
+
+                TraceEvent e;
+                while (owner.pop (e))
+                {
+                    const auto timestamp = (double) (e.ticks - owner.startTicks) / ticksPerMicrosecond;
+
+                    stream << ",\n{\"pid\":1,\"tid\":" << (int) e.track
+                           << ",\"ts\":" << juce::String (timestamp, 3) << ",";
+
+                    switch (e.type)
+                    {
+                        case TraceEventType::blockBegin:
+                            stream << "\"ph\":\"B\",\"name\":\"processBlock\",\"args\":{\"samples\":" << e.arg0 << "}}";
+                            break;
+                        case TraceEventType::voiceBegin:
+                            stream << "\"ph\":\"B\",\"name\":\"render\",\"args\":{\"note\":" << e.arg0
+                                   << ",\"samples\":" << e.arg1 << "}}";
+                            break;
+                        case TraceEventType::blockEnd:
+                        case TraceEventType::voiceEnd:
+                            stream << "\"ph\":\"E\"}";
+                            break;
+                        case TraceEventType::noteOn:
+                            stream << "\"ph\":\"i\",\"s\":\"t\",\"name\":\"note on\",\"args\":{\"note\":" << e.arg0
+                                   << ",\"velocity\":" << e.arg1 << "}}";
+                            break;
+                        case TraceEventType::noteOff:
+                            stream << "\"ph\":\"i\",\"s\":\"t\",\"name\":\"note off\",\"args\":{\"note\":" << e.arg0
+                                   << ",\"tailOff\":" << e.arg1 << "}}";
+                            break;
+                        case TraceEventType::voiceSteal:
+                            stream << "\"ph\":\"i\",\"s\":\"p\",\"name\":\"voice steal\",\"args\":{\"voice\":" << e.arg0
+                                   << ",\"note\":" << e.arg1 << "}}";
+                            break;
+                        case TraceEventType::parameterBurst:
+                            stream << "\"ph\":\"i\",\"s\":\"t\",\"name\":\"parameter changes\",\"args\":{\"count\":" << e.arg0 << "}}";
+                            break;
+                        case TraceEventType::sampleMiss:
+                            stream << "\"ph\":\"i\",\"s\":\"p\",\"name\":\"sample miss\",\"args\":{\"note\":" << e.arg0 << "}}";
+                            break;
+                        case TraceEventType::fxBypass:
+                            stream << "\"ph\":\"i\",\"s\":\"t\",\"name\":\"fx bypass\",\"args\":{\"stage\":\""
+                                   << getFxStageId ((FxStage) e.arg0) << "\",\"enabled\":" << e.arg1 << "}}";
+                            break;
+                        case TraceEventType::qualityStep:
+                            stream << "\"ph\":\"i\",\"s\":\"p\",\"name\":\"quality step\",\"args\":{\"level\":" << e.arg0 << "}}";
+                            break;
+                    }
+                }
+
+                stream.flush();
+            }
+
+            TraceRecorder& owner;
+        };
+
+        //==============================================================================
+        std::unique_ptr<Slot[]> slots;
+        std::atomic<juce::uint64> writePosition { 0 };
+        juce::uint64 readPosition = 0;
+
+        std::atomic<bool> recording { false };
+        std::atomic<int> dropped { 0 };
+        std::atomic<int> parameterChanges { 0 };
+
+        juce::File outputFile;
+        juce::int64 startTicks = 0;
+
+        ParameterCounter parameterCounter { *this };
+        juce::Array<juce::AudioProcessorParameter*> parameters;
+
+        Writer writer;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TraceRecorder)
+    };
+} // namespace soulbass
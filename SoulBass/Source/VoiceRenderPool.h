@@ -0,0 +1,156 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+namespace soulbass
+{
+    //==============================================================================
+    // Small pool of real-time worker threads that runs one batch of independent
+    // tasks at a time, with the calling thread joining in.
+    //
+    // Tasks are handed out by a single atomic claim counter that every thread
+    // (workers and caller alike) pulls from until the batch is empty, so a thread
+    // that finishes early simply takes the next task. The calling side never locks
+    // or allocates: it publishes the batch, wakes the workers, helps, then spins
+    // until the last task is done.
+    class VoiceRenderPool
+    {
+    public:
+        using TaskFunction = void (*) (void* context, int taskIndex);
+
+        VoiceRenderPool() = default;
+
+        ~VoiceRenderPool()
+        {
+            setNumWorkers (0);
+        }
+
+        // Message thread, never while run() is in progress.
+        void setNumWorkers (int numWorkers)
+        {
+            numWorkers = juce::jmax (0, numWorkers);
+
+            if (numWorkers == workers.size())
+                return;
+
+            for (auto* worker : workers)
+                worker->signalThreadShouldExit();
+
+            for (auto* worker : workers)
+                worker->stopThread (2000);
+
+            workers.clear();
+
+            for (int i = 0; i < numWorkers; ++i)
+            {
+                auto* worker = workers.add (new Worker (*this, i));
+
+                if (! worker->startRealtimeThread (juce::Thread::RealtimeOptions()))
+                    worker->startThread (juce::Thread::Priority::highest);
+            }
+        }
+
+        int getNumWorkers() const noexcept { return workers.size(); }
+
+        // Runs task (context, i) for every i in [0, numTasks) and returns when all
+        // of them have finished.
+        void run (int numTasks, TaskFunction taskIn, void* contextIn) noexcept
+        {
+            jassert (numTasks < (int) indexMask);
+
+            task.store (taskIn, std::memory_order_relaxed);
+            context.store (contextIn, std::memory_order_relaxed);
+            remaining.store (numTasks, std::memory_order_relaxed);
+
+            const auto generation = (claim.load (std::memory_order_relaxed) >> generationShift) + 1;
+            claim.store ((generation << generationShift) | ((juce::uint64) numTasks << countShift), std::memory_order_release);
+
+            for (auto* worker : workers)
+                worker->notify();
+
+            help();
+
+            while (remaining.load (std::memory_order_acquire) > 0)
+                spinPause();
+        }
+
+    private:
+        // claim = generation (32 bits) | number of tasks (16 bits) | next task (16 bits).
+        // Carrying the task count in the same word means a late worker can never
+        // pair an old batch's index with a new batch's function.
+        static constexpr int generationShift = 32;
+        static constexpr int countShift = 16;
+        static constexpr juce::uint64 indexMask = 0xffff;
+
+        void help() noexcept
+        {
+            auto current = claim.load (std::memory_order_acquire);
+
+            for (;;)
+            {
+                const auto index = (int) (current & indexMask);
+                const auto count = (int) ((current >> countShift) & indexMask);
+
+                if (index >= count)
+                    return;
+
+                if (claim.compare_exchange_weak (current, current + 1, std::memory_order_acq_rel))
+                {
+                    task.load (std::memory_order_relaxed) (context.load (std::memory_order_relaxed), index);
+                    remaining.fetch_sub (1, std::memory_order_release);
+                    current = claim.load (std::memory_order_acquire);
+                }
+            }
+        }
+
+        static void spinPause() noexcept
+        {
+           #if JUCE_INTEL
+            _mm_pause();
+           #elif JUCE_ARM && ! JUCE_MSVC
+            __asm__ __volatile__ ("yield");
+           #else
+            std::this_thread::yield();
+           #endif
+        }
+
+        //==============================================================================
+        class Worker : public juce::Thread
+        {
+        public:
+            Worker (VoiceRenderPool& ownerIn, int index)
+                : juce::Thread ("SoulBass Voices " + juce::String (index)), owner (ownerIn)
+            {
+            }
+
+            void run() override
+            {
+                // The voices' filters and envelopes decay towards zero here too.
+                juce::ScopedNoDenormals noDenormals;
+
+                while (! threadShouldExit())
+                {
+                    wait (-1);
+                    owner.help();
+                }
+            }
+
+        private:
+            VoiceRenderPool& owner;
+        };
+
+        //==============================================================================
+        std::atomic<juce::uint64> claim { 0 };
+        std::atomic<int> remaining { 0 };
+        std::atomic<TaskFunction> task { nullptr };
+        std::atomic<void*> context { nullptr };
+
+        juce::OwnedArray<Worker> workers;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceRenderPool)
+    };
+} // namespace soulbass
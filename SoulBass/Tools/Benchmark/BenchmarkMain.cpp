@@ -0,0 +1,176 @@
+// soulbass-bench: runs SoulBassAudioProcessor headless over scripted MIDI scenes
+// and reports timing as JSON.
+//
+//   soulbass-bench [--scenes=chords16,rolls808,bendmod] [--fx=none,all]
+//                  [--rates=44100,48000,96000,192000] [--blocks=16,32,...,2048]
+//                  [--seconds=10] [--output=results.json]
+//
+// --fx also accepts single stage ids (eq, dyn, shaper, chorus, delay, reverb) to
+// run that stage on its own.
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "ToolUtils.h"
+
+#include <iostream>
+
+namespace
+{
+    using namespace soulbass::tools;
+
+    struct RunConfig
+    {
+        Scene scene;
+        juce::String fx;
+        double sampleRate;
+        int blockSize;
+    };
+
+    juce::var makeStats (std::vector<double>& values)
+    {
+        auto* stats = new juce::DynamicObject();
+        stats->setProperty ("p50", percentile (values, 50.0));
+        stats->setProperty ("p90", percentile (values, 90.0));
+        stats->setProperty ("p99", percentile (values, 99.0));
+        stats->setProperty ("p999", percentile (values, 99.9));
+        stats->setProperty ("max", values.empty() ? 0.0 : values.back());
+        return stats;
+    }
+
+    juce::var runOne (SoulBassAudioProcessor& processor, const RunConfig& config, double seconds)
+    {
+        auto& state = processor.apvts;
+        applySceneParameters (state, config.scene);
+        applyFxConfig (state, config.fx);
+
+        // Voices still held or releasing from the last run, and its FX tails,
+        // would otherwise be timed as part of this one.
+        processor.reset();
+        processor.setPlayConfigDetails (0, 2, config.sampleRate, config.blockSize);
+        processor.prepareToPlay (config.sampleRate, config.blockSize);
+
+        // Half a second of warm-up so caches, voices and tails settle before timing.
+        const auto warmupSamples = (juce::int64) (0.5 * config.sampleRate);
+        const auto totalSamples = warmupSamples + (juce::int64) (seconds * config.sampleRate);
+        const auto sequence = makeScene (config.scene, (double) totalSamples / config.sampleRate + 1.0);
+
+        SequencePlayer player (sequence, config.sampleRate);
+        juce::AudioBuffer<float> buffer (2, config.blockSize);
+        juce::MidiBuffer midi;
+
+        std::vector<double> blockMicros, blockLoads;
+        blockMicros.reserve ((size_t) (totalSamples / config.blockSize + 1));
+        blockLoads.reserve (blockMicros.capacity());
+
+        const auto deadlineMicros = 1.0e6 * (double) config.blockSize / config.sampleRate;
+        double busySeconds = 0.0;
+
+        while (player.getPosition() < totalSamples)
+        {
+            const bool measuring = player.getPosition() >= warmupSamples;
+            player.fillNextBlock (midi, config.blockSize);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock (buffer, midi);
+            const auto elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+
+            if (measuring)
+            {
+                busySeconds += elapsed;
+                blockMicros.push_back (elapsed * 1.0e6);
+                blockLoads.push_back (elapsed * 1.0e6 / deadlineMicros);
+            }
+        }
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty ("scene", getSceneName (config.scene));
+        result->setProperty ("fx", config.fx);
+        result->setProperty ("sampleRate", config.sampleRate);
+        result->setProperty ("blockSize", config.blockSize);
+        result->setProperty ("blocks", (int) blockMicros.size());
+        result->setProperty ("realtimeFactor", busySeconds > 0.0 ? seconds / busySeconds : 0.0);
+        result->setProperty ("blockMicros", makeStats (blockMicros));
+        result->setProperty ("blockLoad", makeStats (blockLoads));
+        result->setProperty ("peakRssBytes", getPeakResidentSetBytes());
+        return result;
+    }
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    const juce::ArgumentList args (argc, argv);
+
+    auto option = [&args] (const char* name, const char* fallback)
+    {
+        const auto value = args.getValueForOption (name);
+        return value.isNotEmpty() ? value : juce::String (fallback);
+    };
+
+    juce::Array<Scene> scenes;
+    for (auto& name : juce::StringArray::fromTokens (option ("--scenes", "chords16,rolls808,bendmod"), ",", ""))
+    {
+        Scene scene;
+        if (! sceneFromName (name.trim(), scene))
+        {
+            std::cerr << "unknown scene: " << name << std::endl;
+            return 1;
+        }
+        scenes.add (scene);
+    }
+
+    const auto fxConfigs = juce::StringArray::fromTokens (option ("--fx", "none,all"), ",", "");
+    const auto rates = parseIntList (option ("--rates", "44100,48000,96000,192000"));
+    const auto blocks = parseIntList (option ("--blocks", "16,32,64,128,256,512,1024,2048"));
+    const auto seconds = juce::jmax (0.1, option ("--seconds", "10").getDoubleValue());
+
+    SoulBassAudioProcessor processor;
+    juce::Array<juce::var> results;
+
+    for (auto scene : scenes)
+    {
+        for (auto& fx : fxConfigs)
+        {
+            if (! applyFxConfig (processor.apvts, fx.trim()))
+            {
+                std::cerr << "unknown fx config: " << fx << std::endl;
+                return 1;
+            }
+
+            for (auto rate : rates)
+            {
+                for (auto block : blocks)
+                {
+                    std::cerr << getSceneName (scene) << " fx=" << fx << " " << rate << " Hz, " << block << " samples" << std::endl;
+                    results.add (runOne (processor, { scene, fx.trim(), (double) rate, block }, seconds));
+                }
+            }
+        }
+    }
+
+    processor.releaseResources();
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty ("tool", "soulbass-bench");
+    report->setProperty ("version", SOULBASS_VERSION_STRING);
+    report->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+    report->setProperty ("secondsPerRun", seconds);
+    report->setProperty ("peakRssBytes", getPeakResidentSetBytes());
+    report->setProperty ("results", results);
+
+    const auto json = juce::JSON::toString (juce::var (report));
+    const auto outputPath = args.getValueForOption ("--output");
+
+    if (outputPath.isEmpty())
+    {
+        std::cout << json << std::endl;
+    }
+    else if (! juce::File::getCurrentWorkingDirectory().getChildFile (outputPath).replaceWithText (json))
+    {
+        std::cerr << "could not write " << outputPath << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+ #include <psapi.h>
+ #pragma comment (lib, "psapi.lib")
+#else
+ #include <sys/resource.h>
+#endif
+
+// Shared helpers for the headless tools: parameter access, deterministic MIDI
+// scenes and a few measurement utilities.
+namespace soulbass::tools
+{
+    //==============================================================================
+    // Sets a parameter from its real-world value (dB, Hz, choice index...).
+    inline void setParameter (juce::AudioProcessorValueTreeState& state, const juce::String& id, float value)
+    {
+        if (auto* p = state.getParameter (id))
+            p->setValueNotifyingHost (p->convertTo0to1 (value));
+    }
+
+    inline void setFxStageEnabled (juce::AudioProcessorValueTreeState& state, FxStage stage, bool enabled)
+    {
+        setParameter (state, getFxStageEnableParameter (stage), enabled ? 1.0f : 0.0f);
+    }
+
+    // "none", "all" or a single stage id ("eq", "dyn", ...) to run on its own.
+    inline bool applyFxConfig (juce::AudioProcessorValueTreeState& state, const juce::String& config)
+    {
+        bool known = config == "none" || config == "all";
+
+        for (int s = 0; s < numFxStages; ++s)
+        {
+            const auto stage = (FxStage) s;
+            const bool solo = config == getFxStageId (stage);
+            known = known || solo;
+            setFxStageEnabled (state, stage, config == "all" || solo);
+        }
+
+        return known;
+    }
+
+    //==============================================================================
+    enum class Scene
+    {
+        chords16 = 0,
+        rolls808,
+        bendAndModWheel
+    };
+
+    constexpr int numScenes = 3;
+
+    inline const char* getSceneName (Scene scene)
+    {
+        switch (scene)
+        {
+            case Scene::chords16:        return "chords16";
+            case Scene::rolls808:        return "rolls808";
+            case Scene::bendAndModWheel: return "bendmod";
+        }
+
+        return "";
+    }
+
+    inline bool sceneFromName (const juce::String& name, Scene& result)
+    {
+        for (int s = 0; s < numScenes; ++s)
+        {
+            if (name == getSceneName ((Scene) s))
+            {
+                result = (Scene) s;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Voice setup each scene is written for (polyphony choice index, legato).
+    inline void applySceneParameters (juce::AudioProcessorValueTreeState& state, Scene scene)
+    {
+        switch (scene)
+        {
+            case Scene::chords16:        setParameter (state, "polyphony", 5.0f); break; // 16 voices
+            case Scene::rolls808:        setParameter (state, "polyphony", 4.0f); break; // 8 voices
+            case Scene::bendAndModWheel: setParameter (state, "polyphony", 3.0f); break; // 4 voices
+        }
+
+        setParameter (state, "legato", 0.0f);
+        setParameter (state, "glideEnabled", 0.0f);
+    }
+
+    // Deterministic MIDI for a scene, timestamps in seconds. Samples are mapped
+    // one per key from C2 (36); the 808s sit on 71-74 and 76, with the Reese
+    // between them on 75.
+    inline juce::MidiMessageSequence makeScene (Scene scene, double lengthSeconds)
+    {
+        juce::MidiMessageSequence seq;
+
+        auto addNote = [&seq] (int note, float velocity, double start, double length)
+        {
+            seq.addEvent (juce::MidiMessage::noteOn (1, note, velocity), start);
+            seq.addEvent (juce::MidiMessage::noteOff (1, note), start + length);
+        };
+
+        switch (scene)
+        {
+            case Scene::chords16:
+            {
+                // Sixteen different samples struck together every two seconds.
+                for (double t = 0.0; t < lengthSeconds; t += 2.0)
+                    for (int n = 0; n < 16; ++n)
+                        addNote (36 + n * 2, 0.6f + 0.02f * (float) n, t, 1.9);
+                break;
+            }
+
+            case Scene::rolls808:
+            {
+                // 32nd-note ratchets at 150 bpm, walking round keys 71-76.
+                const double step = 60.0 / 150.0 / 8.0;
+                int i = 0;
+                for (double t = 0.0; t < lengthSeconds; t += step, ++i)
+                    addNote (71 + (i / 4) % 6, 0.5f + 0.5f * (float) ((i % 4) + 1) / 4.0f, t, step * 0.8);
+                break;
+            }
+
+            case Scene::bendAndModWheel:
+            {
+                // A held four-note chord under a pitch-bend event every millisecond and
+                // a mod-wheel event every two.
+                for (double t = 0.0; t < lengthSeconds; t += 4.0)
+                    for (int note : { 36, 43, 48, 55 })
+                        addNote (note, 0.8f, t, 3.9);
+
+                for (double t = 0.0; t < lengthSeconds; t += 0.001)
+                {
+                    const auto bend = 0.5 + 0.5 * std::sin (juce::MathConstants<double>::twoPi * 5.0 * t);
+                    seq.addEvent (juce::MidiMessage::pitchWheel (1, juce::jlimit (0, 16383, (int) (bend * 16383.0))), t);
+
+                    if (((int) std::round (t * 1000.0)) % 2 == 0)
+                    {
+                        const auto wheel = std::abs (std::fmod (t * 0.5, 2.0) - 1.0);
+                        seq.addEvent (juce::MidiMessage::controllerEvent (1, 1, (int) (wheel * 127.0)), t);
+                    }
+                }
+                break;
+            }
+        }
+
+        seq.updateMatchedPairs();
+        seq.sort();
+        return seq;
+    }
+
+    //==============================================================================
+    // Feeds a sequence (timestamps in seconds) to processBlock one block at a time.
+    class SequencePlayer
+    {
+    public:
+        SequencePlayer (const juce::MidiMessageSequence& sequenceIn, double sampleRateIn)
+            : sequence (sequenceIn), sampleRate (sampleRateIn)
+        {
+        }
+
+        void fillNextBlock (juce::MidiBuffer& midi, int numSamples)
+        {
+            midi.clear();
+            const auto blockEnd = position + numSamples;
+
+            while (nextEvent < sequence.getNumEvents())
+            {
+                const auto& message = sequence.getEventPointer (nextEvent)->message;
+                const auto samplePosition = (juce::int64) std::llround (message.getTimeStamp() * sampleRate);
+
+                if (samplePosition >= blockEnd)
+                    break;
+
+                midi.addEvent (message, (int) juce::jmax ((juce::int64) 0, samplePosition - position));
+                ++nextEvent;
+            }
+
+            position = blockEnd;
+        }
+
+        juce::int64 getPosition() const noexcept { return position; }
+
+    private:
+        const juce::MidiMessageSequence& sequence;
+        double sampleRate;
+        juce::int64 position = 0;
+        int nextEvent = 0;
+    };
+
+    //==============================================================================
+    // Nearest-rank percentile; sorts the values in place.
+    inline double percentile (std::vector<double>& values, double p)
+    {
+        if (values.empty())
+            return 0.0;
+
+        std::sort (values.begin(), values.end());
+        const auto rank = (size_t) std::ceil (p / 100.0 * (double) values.size());
+        return values[juce::jlimit ((size_t) 0, values.size() - 1, rank == 0 ? 0 : rank - 1)];
+    }
+
+    inline juce::int64 getPeakResidentSetBytes()
+    {
+       #if JUCE_WINDOWS
+        PROCESS_MEMORY_COUNTERS counters {};
+        if (GetProcessMemoryInfo (GetCurrentProcess(), &counters, sizeof (counters)))
+            return (juce::int64) counters.PeakWorkingSetSize;
+        return 0;
+       #else
+        rusage usage {};
+        getrusage (RUSAGE_SELF, &usage);
+       #if JUCE_MAC
+        return (juce::int64) usage.ru_maxrss;           // bytes
+       #else
+        return (juce::int64) usage.ru_maxrss * 1024;    // kilobytes
+       #endif
+       #endif
+    }
+
+    inline juce::Array<int> parseIntList (const juce::String& text)
+    {
+        juce::Array<int> values;
+        for (auto& token : juce::StringArray::fromTokens (text, ",", ""))
+            if (token.trim().isNotEmpty())
+                values.add (token.trim().getIntValue());
+        return values;
+    }
+} // namespace soulbass::tools
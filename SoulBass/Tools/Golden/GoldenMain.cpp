@@ -0,0 +1,433 @@
+// soulbass-golden: renders deterministic MIDI scenes through SoulBassAudioProcessor
+// and checks them against stored reference renders.
+//
+//   soulbass-golden record --dir=golden [--rate=48000] [--block=256] [--seconds=4]
+//                          [--scenes=...] [--fx=none,eq,dyn,shaper,chorus,delay,reverb,all]
+//   soulbass-golden verify --dir=golden [--paths=fast,reference] [--budget=dyn:-50:0.25,...]
+//
+// record always renders on the reference path. verify renders every recorded case
+// on each requested path and compares it with the reference WAV: the largest
+// sample difference in dBFS and the worst per-frame log-spectral distance in dB,
+// each against the budget of the case's FX stage. With both paths it also compares
+// them with each other. Exits with 1 if anything is over budget.
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "ToolUtils.h"
+
+#include <iostream>
+
+namespace
+{
+    using namespace soulbass::tools;
+
+    constexpr double tailSeconds = 2.0;
+
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        double seconds = 4.0;
+    };
+
+    struct Case
+    {
+        Scene scene;
+        juce::String fx;
+
+        juce::String getName() const { return juce::String (getSceneName (scene)) + "-" + fx; }
+    };
+
+    //==============================================================================
+    // Error budgets per FX configuration: the largest sample difference allowed, in
+    // dBFS, and the largest log-spectral distance of any analysis frame, in dB.
+    struct Budget
+    {
+        float maxAbsDb;
+        float spectralDb;
+    };
+
+    std::map<juce::String, Budget> getDefaultBudgets()
+    {
+        return {
+            { "none",   { -70.0f, 0.10f } },
+            { "eq",     { -70.0f, 0.10f } },
+            { "dyn",    { -50.0f, 0.25f } },
+            { "shaper", { -60.0f, 0.20f } },
+            { "chorus", { -60.0f, 0.15f } },
+            { "delay",  { -70.0f, 0.10f } },
+            { "reverb", { -60.0f, 0.15f } },
+            { "all",    { -45.0f, 0.30f } }
+        };
+    }
+
+    // "stage:maxAbsDb:spectralDb", comma separated.
+    bool parseBudgets (const juce::String& text, std::map<juce::String, Budget>& budgets)
+    {
+        for (auto& token : juce::StringArray::fromTokens (text, ",", ""))
+        {
+            if (token.trim().isEmpty())
+                continue;
+
+            const auto parts = juce::StringArray::fromTokens (token.trim(), ":", "");
+            if (parts.size() != 3 || budgets.find (parts[0]) == budgets.end())
+                return false;
+
+            budgets[parts[0]] = { parts[1].getFloatValue(), parts[2].getFloatValue() };
+        }
+
+        return true;
+    }
+
+    //==============================================================================
+    // A fresh processor per render, so no state carries over from the previous case.
+    juce::AudioBuffer<float> renderCase (const Case& c, const Settings& settings, bool referencePath)
+    {
+        SoulBassAudioProcessor processor;
+        processor.setReferencePathEnabled (referencePath);
+        applySceneParameters (processor.apvts, c.scene);
+        applyFxConfig (processor.apvts, c.fx);
+
+        processor.setPlayConfigDetails (0, 2, settings.sampleRate, settings.blockSize);
+        processor.prepareToPlay (settings.sampleRate, settings.blockSize);
+
+        const auto totalSamples = (int) std::llround ((settings.seconds + tailSeconds) * settings.sampleRate);
+        const auto sequence = makeScene (c.scene, settings.seconds);
+
+        SequencePlayer player (sequence, settings.sampleRate);
+        juce::AudioBuffer<float> output (2, totalSamples), block (2, settings.blockSize);
+        juce::MidiBuffer midi;
+
+        for (int position = 0; position < totalSamples; position += settings.blockSize)
+        {
+            const auto num = juce::jmin (settings.blockSize, totalSamples - position);
+            block.setSize (2, num, false, false, true);
+
+            player.fillNextBlock (midi, num);
+            processor.processBlock (block, midi);
+
+            for (int ch = 0; ch < 2; ++ch)
+                output.copyFrom (ch, position, block, ch, 0, num);
+        }
+
+        processor.releaseResources();
+        return output;
+    }
+
+    //==============================================================================
+    float getMaxAbsErrorDb (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        float maxError = 0.0f;
+
+        for (int ch = 0; ch < a.getNumChannels(); ++ch)
+        {
+            const auto* x = a.getReadPointer (ch);
+            const auto* y = b.getReadPointer (ch);
+
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                maxError = juce::jmax (maxError, std::abs (x[i] - y[i]));
+        }
+
+        return juce::Decibels::gainToDecibels (maxError, -200.0f);
+    }
+
+    // Worst RMS difference of the dB magnitude spectra over all half-overlapping
+    // Hann frames. Bins more than 80 dB below the frame's peak and silent frames
+    // are ignored, so noise-floor wobble doesn't count.
+    float getSpectralDifferenceDb (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        constexpr int order = 11;
+        constexpr int size = 1 << order;
+        constexpr int hop = size / 2;
+        constexpr float silence = (float) size * 1.0e-6f;
+        const auto relativeFloor = juce::Decibels::decibelsToGain (-80.0f);
+
+        juce::dsp::FFT fft (order);
+        std::vector<float> window ((size_t) size), fa ((size_t) size * 2), fb ((size_t) size * 2);
+
+        for (int i = 0; i < size; ++i)
+            window[(size_t) i] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) size);
+
+        float worst = 0.0f;
+
+        for (int ch = 0; ch < a.getNumChannels(); ++ch)
+        {
+            for (int start = 0; start + size <= a.getNumSamples(); start += hop)
+            {
+                std::fill (fa.begin(), fa.end(), 0.0f);
+                std::fill (fb.begin(), fb.end(), 0.0f);
+                juce::FloatVectorOperations::multiply (fa.data(), a.getReadPointer (ch, start), window.data(), size);
+                juce::FloatVectorOperations::multiply (fb.data(), b.getReadPointer (ch, start), window.data(), size);
+
+                fft.performFrequencyOnlyForwardTransform (fa.data(), true);
+                fft.performFrequencyOnlyForwardTransform (fb.data(), true);
+
+                const auto peak = juce::jmax (juce::FloatVectorOperations::findMaximum (fa.data(), size / 2 + 1),
+                                              juce::FloatVectorOperations::findMaximum (fb.data(), size / 2 + 1));
+                if (peak < silence)
+                    continue;
+
+                const auto floor = peak * relativeFloor;
+                double sum = 0.0;
+                int count = 0;
+
+                for (int bin = 1; bin <= size / 2; ++bin)
+                {
+                    const auto x = fa[(size_t) bin], y = fb[(size_t) bin];
+                    if (juce::jmax (x, y) < floor)
+                        continue;
+
+                    const auto difference = 20.0 * std::log10 ((double) juce::jmax (x, floor) / (double) juce::jmax (y, floor));
+                    sum += difference * difference;
+                    ++count;
+                }
+
+                if (count > 0)
+                    worst = juce::jmax (worst, (float) std::sqrt (sum / count));
+            }
+        }
+
+        return worst;
+    }
+
+    //==============================================================================
+    bool writeWav (const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate)
+    {
+        file.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream> (file);
+        if (! stream->openedOk())
+            return false;
+
+        // 32-bit float, so the reference is exactly what was rendered.
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), sampleRate,
+                                                                              (unsigned int) buffer.getNumChannels(),
+                                                                              32, {}, 0));
+        if (writer == nullptr)
+            return false;
+
+        stream.release();
+        return writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+    }
+
+    bool readWav (const juce::File& file, juce::AudioBuffer<float>& buffer)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (file));
+        if (reader == nullptr)
+            return false;
+
+        buffer.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);
+        return reader->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
+    }
+
+    //==============================================================================
+    int record (const juce::File& dir, const Settings& settings, const juce::Array<Case>& cases)
+    {
+        if (dir.createDirectory().failed())
+        {
+            std::cerr << "could not create " << dir.getFullPathName() << std::endl;
+            return 2;
+        }
+
+        juce::Array<juce::var> entries;
+
+        for (auto& c : cases)
+        {
+            std::cerr << "recording " << c.getName() << std::endl;
+            const auto file = dir.getChildFile (c.getName() + ".wav");
+
+            if (! writeWav (file, renderCase (c, settings, true), settings.sampleRate))
+            {
+                std::cerr << "could not write " << file.getFullPathName() << std::endl;
+                return 2;
+            }
+
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty ("scene", getSceneName (c.scene));
+            entry->setProperty ("fx", c.fx);
+            entry->setProperty ("file", file.getFileName());
+            entries.add (entry);
+        }
+
+        auto* manifest = new juce::DynamicObject();
+        manifest->setProperty ("version", SOULBASS_VERSION_STRING);
+        manifest->setProperty ("sampleRate", settings.sampleRate);
+        manifest->setProperty ("blockSize", settings.blockSize);
+        manifest->setProperty ("seconds", settings.seconds);
+        manifest->setProperty ("cases", entries);
+
+        if (! dir.getChildFile ("golden.json").replaceWithText (juce::JSON::toString (juce::var (manifest))))
+        {
+            std::cerr << "could not write golden.json" << std::endl;
+            return 2;
+        }
+
+        return 0;
+    }
+
+    bool checkAgainst (const juce::String& label, const juce::AudioBuffer<float>& rendered,
+                       const juce::AudioBuffer<float>& expected, const Budget& budget)
+    {
+        if (rendered.getNumChannels() != expected.getNumChannels()
+            || rendered.getNumSamples() != expected.getNumSamples())
+        {
+            std::cout << label.paddedRight (' ', 40) << "length or channel count differs  FAIL" << std::endl;
+            return false;
+        }
+
+        const auto maxAbsDb = getMaxAbsErrorDb (rendered, expected);
+        const auto spectralDb = getSpectralDifferenceDb (rendered, expected);
+        const bool passed = maxAbsDb <= budget.maxAbsDb && spectralDb <= budget.spectralDb;
+
+        std::cout << label.paddedRight (' ', 40)
+                  << "max " << juce::String (maxAbsDb, 1).paddedLeft (' ', 7) << " dBFS (" << juce::String (budget.maxAbsDb, 1) << ")  "
+                  << "spectral " << juce::String (spectralDb, 3).paddedLeft (' ', 6) << " dB (" << juce::String (budget.spectralDb, 2) << ")  "
+                  << (passed ? "ok" : "FAIL") << std::endl;
+
+        return passed;
+    }
+
+    int verify (const juce::File& dir, const juce::StringArray& paths, const std::map<juce::String, Budget>& budgets)
+    {
+        const auto manifest = juce::JSON::parse (dir.getChildFile ("golden.json"));
+        if (! manifest.isObject())
+        {
+            std::cerr << "no golden.json in " << dir.getFullPathName() << "; run record first" << std::endl;
+            return 2;
+        }
+
+        Settings settings;
+        settings.sampleRate = (double) manifest["sampleRate"];
+        settings.blockSize = (int) manifest["blockSize"];
+        settings.seconds = (double) manifest["seconds"];
+
+        int failures = 0;
+
+        if (auto* entries = manifest["cases"].getArray())
+        {
+            for (auto& entry : *entries)
+            {
+                Case c;
+                if (! sceneFromName (entry["scene"].toString(), c.scene))
+                {
+                    std::cerr << "unknown scene in manifest: " << entry["scene"].toString() << std::endl;
+                    return 2;
+                }
+
+                c.fx = entry["fx"].toString();
+                const auto budget = budgets.find (c.fx);
+                if (budget == budgets.end())
+                {
+                    std::cerr << "no budget for fx config " << c.fx << std::endl;
+                    return 2;
+                }
+
+                juce::AudioBuffer<float> expected;
+                if (! readWav (dir.getChildFile (entry["file"].toString()), expected))
+                {
+                    std::cout << c.getName().paddedRight (' ', 40) << "missing reference  FAIL" << std::endl;
+                    ++failures;
+                    continue;
+                }
+
+                std::map<juce::String, juce::AudioBuffer<float>> renders;
+
+                for (auto& path : paths)
+                {
+                    renders[path] = renderCase (c, settings, path == "reference");
+                    if (! checkAgainst (c.getName() + " " + path, renders[path], expected, budget->second))
+                        ++failures;
+                }
+
+                // The fast path measured against the reference path rendered right now,
+                // independent of how old the stored renders are.
+                if (renders.size() == 2)
+                    if (! checkAgainst (c.getName() + " fast/reference", renders["fast"], renders["reference"], budget->second))
+                        ++failures;
+            }
+        }
+
+        std::cout << (failures == 0 ? juce::String ("all cases within budget")
+                                    : juce::String (failures) + " check(s) over budget") << std::endl;
+        return failures == 0 ? 0 : 1;
+    }
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    const juce::ArgumentList args (argc, argv);
+
+    auto option = [&args] (const char* name, const char* fallback)
+    {
+        const auto value = args.getValueForOption (name);
+        return value.isNotEmpty() ? value : juce::String (fallback);
+    };
+
+    const auto command = args.size() > 0 ? args[0].text : juce::String();
+    const auto dir = juce::File::getCurrentWorkingDirectory().getChildFile (option ("--dir", "golden"));
+
+    if (command == "record")
+    {
+        Settings settings;
+        settings.sampleRate = option ("--rate", "48000").getDoubleValue();
+        settings.blockSize = juce::jmax (1, option ("--block", "256").getIntValue());
+        settings.seconds = juce::jmax (0.5, option ("--seconds", "4").getDoubleValue());
+
+        juce::Array<Case> cases;
+        const auto fxConfigs = juce::StringArray::fromTokens (option ("--fx", "none,eq,dyn,shaper,chorus,delay,reverb,all"), ",", "");
+
+        for (auto& name : juce::StringArray::fromTokens (option ("--scenes", "chords16,rolls808,bendmod"), ",", ""))
+        {
+            Scene scene;
+            if (! sceneFromName (name.trim(), scene))
+            {
+                std::cerr << "unknown scene: " << name << std::endl;
+                return 2;
+            }
+
+            for (auto& fx : fxConfigs)
+            {
+                if (getDefaultBudgets().count (fx.trim()) == 0)
+                {
+                    std::cerr << "unknown fx config: " << fx << std::endl;
+                    return 2;
+                }
+
+                cases.add ({ scene, fx.trim() });
+            }
+        }
+
+        return record (dir, settings, cases);
+    }
+
+    if (command == "verify")
+    {
+        auto budgets = getDefaultBudgets();
+        if (! parseBudgets (args.getValueForOption ("--budget"), budgets))
+        {
+            std::cerr << "bad --budget; expected stage:maxAbsDb:spectralDb" << std::endl;
+            return 2;
+        }
+
+        juce::StringArray paths;
+        for (auto& path : juce::StringArray::fromTokens (option ("--paths", "fast,reference"), ",", ""))
+        {
+            if (path.trim() != "fast" && path.trim() != "reference")
+            {
+                std::cerr << "unknown path: " << path << std::endl;
+                return 2;
+            }
+
+            paths.addIfNotAlreadyThere (path.trim());
+        }
+
+        return verify (dir, paths, budgets);
+    }
+
+    std::cerr << "usage: soulbass-golden record|verify [--dir=golden] ..." << std::endl;
+    return 2;
+}
@@ -0,0 +1,553 @@
+// soulbass-kernels: times the individual DSP hot loops in isolation.
+//
+//   soulbass-kernels [--kernels=voice,svf,...] [--blocks=16,64,256,1024]
+//                    [--rate=48000] [--json=kernels.json]
+//
+// Every kernel is reported in ns/sample, warm (state and buffers resident in
+// cache, median of several batches) and cold (caches flushed before each block).
+
+#include <JuceHeader.h>
+#include "SoulSampler.h"
+#include "FxKernels.h"
+#include "DynamicsProcessor.h"
+#include "EnsembleChorus.h"
+#include "ConvolutionReverb.h"
+#include "ToolUtils.h"
+
+#include <iostream>
+
+namespace
+{
+    //==============================================================================
+    struct Kernel
+    {
+        virtual ~Kernel() = default;
+        virtual void prepare (double sampleRate, int blockSize) = 0;
+        virtual void process (juce::AudioBuffer<float>& buffer) = 0;
+    };
+
+    // One SampleVoice playing a long synthetic sample through a Synthesiser, so
+    // the real render loop (interpolation, envelope, filter, LFO) is measured.
+    // With sustain set the sample is a steady tone, played as its attack plus
+    // the extracted wavetable.
+    struct VoiceKernel : Kernel
+    {
+        explicit VoiceKernel (bool modulatedIn, int unisonVoicesIn = 1,
+                              soulbass::FilterType filterTypeIn = soulbass::FilterType::lowPass,
+                              bool sustainIn = false)
+            : modulated (modulatedIn), unisonVoices (unisonVoicesIn), filterType (filterTypeIn), sustain (sustainIn) {}
+
+        void prepare (double sampleRate, int blockSize) override
+        {
+            synth.clearVoices();
+            synth.clearSounds();
+
+            auto* voice = new soulbass::SampleVoice();
+            synth.addVoice (voice);
+            synth.setCurrentPlaybackSampleRate (sampleRate);
+            voice->prepare ({ sampleRate, (juce::uint32) blockSize, 2 });
+            voice->setEnvelope ({ 0.005f, 0.2f, 0.8f, 0.3f });
+            voice->setFilter (filterType, modulated ? 800.0f : 20000.0f, 0.7f);
+            voice->setLfo (5.0f, modulated ? 1.0f : 0.0f, 0.0f, 0.2f);
+            voice->setModWheel (modulated ? 1.0f : 0.0f);
+            voice->setUnison (unisonVoices, 20.0f, 0.7f, 1.0f);
+
+            auto data = std::make_unique<juce::AudioBuffer<float>> (2, (int) (sampleRate * 30.0));
+            juce::Random random (1);
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < data->getNumSamples(); ++i)
+                    data->setSample (ch, i, sustain ? steadyTone (ch, i) : random.nextFloat() * 2.0f - 1.0f);
+
+            std::shared_ptr<const juce::AudioBuffer<float>> sampleData = std::move (data);
+            std::shared_ptr<const soulbass::SustainWavetable> table;
+
+            if (sustain && (table = soulbass::SustainWavetable::extract (*sampleData, 44100.0)) != nullptr)
+                sampleData = table->makeAttack (*sampleData);
+
+            synth.addSound (new soulbass::SampleSound ("bench", std::move (sampleData), 44100.0, 0, 127, 60,
+                                                       sustain ? steadyToneHz : juce::MidiMessage::getMidiNoteInHertz (60),
+                                                       std::move (table)));
+
+            // A fifth above the root keeps the read position fractional.
+            midi.clear();
+            midi.addEvent (juce::MidiMessage::noteOn (1, 67, 0.8f), 0);
+        }
+
+        void process (juce::AudioBuffer<float>& buffer) override
+        {
+            buffer.clear();
+
+            if (synth.getVoice (0)->isVoiceActive())
+                midi.clear();
+            else
+                midi.addEvent (juce::MidiMessage::noteOn (1, 67, 0.8f), 0);
+
+            synth.renderNextBlock (buffer, midi, 0, buffer.getNumSamples());
+        }
+
+        // A few harmonics of C2 at 44.1 kHz, so the period is fractional.
+        static constexpr double steadyToneHz = 65.40639;
+
+        static float steadyTone (int channel, int index)
+        {
+            const auto phase = juce::MathConstants<double>::twoPi * steadyToneHz * index / 44100.0 + 0.3 * channel;
+            return (float) (0.5 * std::sin (phase) + 0.25 * std::sin (2.0 * phase) + 0.125 * std::sin (3.0 * phase + 1.0));
+        }
+
+        bool modulated;
+        int unisonVoices;
+        soulbass::FilterType filterType;
+        bool sustain;
+        juce::Synthesiser synth;
+        juce::MidiBuffer midi;
+    };
+
+    // The voice filter on its own, in its state-variable low-pass mode, cutoff
+    // swept every sample.
+    struct SvfKernel : Kernel
+    {
+        void prepare (double sampleRate, int) override
+        {
+            filter.setSampleRate (sampleRate);
+            filter.setType (soulbass::FilterType::lowPass);
+            filter.setResonance (0.9f);
+            filter.reset();
+            increment = juce::MathConstants<float>::twoPi * 3.0f / (float) sampleRate;
+        }
+
+        void process (juce::AudioBuffer<float>& buffer) override
+        {
+            auto* left = buffer.getWritePointer (0);
+            auto* right = buffer.getWritePointer (1);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                phase += increment;
+                if (phase > juce::MathConstants<float>::twoPi)
+                    phase -= juce::MathConstants<float>::twoPi;
+
+                filter.setCutoffFrequency (1200.0f * (1.0f + 0.5f * std::sin (phase)));
+                left[i] = filter.processSample<false> (0, left[i]);
+                right[i] = filter.processSample<false> (1, right[i]);
+            }
+        }
+
+        soulbass::VoiceFilter filter;
+        float phase = 0.0f, increment = 0.0f;
+    };
+
+    struct AdsrKernel : Kernel
+    {
+        void prepare (double sampleRate, int) override
+        {
+            adsr.setSampleRate (sampleRate);
+            adsr.setParameters ({ 0.01f, 0.3f, 0.7f, 0.5f });
+            samplesPerToggle = (int) sampleRate;
+            samplesUntilToggle = samplesPerToggle;
+        }
+
+        void process (juce::AudioBuffer<float>& buffer) override
+        {
+            // Alternate a second held with a second released so every segment runs.
+            if ((samplesUntilToggle -= buffer.getNumSamples()) <= 0)
+            {
+                held = ! held;
+                samplesUntilToggle += samplesPerToggle;
+
+                if (held)
+                    adsr.noteOn();
+                else
+                    adsr.noteOff();
+            }
+
+            auto* left = buffer.getWritePointer (0);
+            auto* right = buffer.getWritePointer (1);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                const auto env = adsr.getNextSample();
+                left[i] *= env;
+                right[i] *= env;
+            }
+        }
+
+        juce::ADSR adsr;
+        int samplesPerToggle = 0, samplesUntilToggle = 0;
+        bool held = false;
+    };
+
+    // The same pattern through the voice's block envelope, a segment run at a time.
+    struct EnvelopeKernel : Kernel
+    {
+        void prepare (double sampleRate, int) override
+        {
+            envelope.setSampleRate (sampleRate);
+            envelope.setParameters ({ 0.01f, 0.3f, 0.7f, 0.5f });
+            envelope.setFloor (1.585e-5f);
+            samplesPerToggle = (int) sampleRate;
+            samplesUntilToggle = samplesPerToggle;
+        }
+
+        void process (juce::AudioBuffer<float>& buffer) override
+        {
+            if ((samplesUntilToggle -= buffer.getNumSamples()) <= 0)
+            {
+                held = ! held;
+                samplesUntilToggle += samplesPerToggle;
+
+                if (held)
+                    envelope.noteOn();
+                else
+                    envelope.noteOff();
+            }
+
+            auto* left = buffer.getWritePointer (0);
+            auto* right = buffer.getWritePointer (1);
+
+            for (int i = 0; i < buffer.getNumSamples();)
+            {
+                const auto num = juce::jmin (buffer.getNumSamples() - i, (int) run.size());
+                const auto rendered = envelope.render (run.data(), num);
+
+                if (rendered == 0)
+                {
+                    // Sustaining or idle: the level holds.
+                    juce::FloatVectorOperations::multiply (left + i, envelope.getValue(), num);
+                    juce::FloatVectorOperations::multiply (right + i, envelope.getValue(), num);
+                    i += num;
+                    continue;
+                }
+
+                juce::FloatVectorOperations::multiply (left + i, run.data(), rendered);
+                juce::FloatVectorOperations::multiply (right + i, run.data(), rendered);
+                i += rendered;
+            }
+        }
+
+        soulbass::BlockEnvelope envelope;
+        std::array<float, 128> run {};
+        int samplesPerToggle = 0, samplesUntilToggle = 0;
+        bool held = false;
+    };
+
+    struct ShaperKernel : Kernel
+    {
+        explicit ShaperKernel (int type) { shaper.type = type; shaper.drive = 2.0f; shaper.bias = 0.05f; }
+
+        void prepare (double, int) override {}
+
+        void process (juce::AudioBuffer<float>& buffer) override
+        {
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            {
+                auto* data = buffer.getWritePointer (ch);
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                    data[i] = shaper.processSample (data[i]);
+            }
+        }
+
+        soulbass::Shaper shaper;
+    };
+
+    struct EqKernel : Kernel
+    {
+        void prepare (double sampleRate, int blockSize) override
+        {
+            eq.prepare ({ sampleRate, (juce::uint32) blockSize, 2 });
+            eq.setBandCoefficients (0, *juce::dsp::IIR::Coefficients<float>::makeLowShelf (sampleRate, 80.0f, 0.7f, 1.5f));
+            eq.setBandCoefficients (1, *juce::dsp::IIR::Coefficients<float>::makePeakFilter (sampleRate, 600.0f, 1.0f, 0.7f));
+            eq.setBandCoefficients (2, *juce::dsp::IIR::Coefficients<float>::makeHighShelf (sampleRate, 6000.0f, 0.8f, 1.3f));
+        }
+
+        void process (juce::AudioBuffer<float>& buffer) override
+        {
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            {
+                auto* data = buffer.getWritePointer (ch);
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                    data[i] = eq.processSample (ch, data[i]);
+            }
+
+            eq.snapToZero();
+        }
+
+        soulbass::ThreeBandEq eq;
+    };
+
+    // Same loop as SoulBassAudioProcessor::processDelay.
+    struct DelayKernel : Kernel
+    {
+        void prepare (double sampleRate, int blockSize) override
+        {
+            delay.prepare ({ sampleRate, (juce::uint32) blockSize, 2 });
+            delaySamples = (float) (0.28 * sampleRate);
+            delay.setDelay (delaySamples);
+        }
+
+        void process (juce::AudioBuffer<float>& buffer) override
+        {
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            {
+                auto* data = buffer.getWritePointer (ch);
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                {
+                    const auto dry = data[i];
+                    const auto delayed = delay.popSample (ch, delaySamples);
+                    data[i] = dry + delayed * 0.35f;
+                    delay.pushSample (ch, dry + delayed * 0.35f);
+                }
+            }
+        }
+
+        juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear> delay { 192000 };
+        float delaySamples = 0.0f;
+    };
+
+    // Wraps any juce::dsp-style processor with prepare/process(context).
+    template <typename Processor>
+    struct ContextKernel : Kernel
+    {
+        template <typename Setup>
+        explicit ContextKernel (Setup&& setupIn) : setup (std::forward<Setup> (setupIn)) {}
+
+        void prepare (double sampleRate, int blockSize) override
+        {
+            processor.prepare ({ sampleRate, (juce::uint32) blockSize, 2 });
+            setup (processor);
+        }
+
+        void process (juce::AudioBuffer<float>& buffer) override
+        {
+            juce::dsp::AudioBlock<float> block (buffer);
+            processor.process (juce::dsp::ProcessContextReplacing<float> (block));
+        }
+
+        Processor processor;
+        std::function<void (Processor&)> setup;
+    };
+
+    //==============================================================================
+    std::unique_ptr<Kernel> createKernel (const juce::String& name)
+    {
+        if (name == "voice")        return std::make_unique<VoiceKernel> (false);
+        if (name == "voice-mod")    return std::make_unique<VoiceKernel> (true);
+        if (name == "voice-unison") return std::make_unique<VoiceKernel> (false, soulbass::UnisonStack::maxVoices);
+        if (name == "voice-ladder") return std::make_unique<VoiceKernel> (true, 1, soulbass::FilterType::ladder);
+        if (name == "voice-sustain") return std::make_unique<VoiceKernel> (false, 1, soulbass::FilterType::lowPass, true);
+        if (name == "svf")          return std::make_unique<SvfKernel>();
+        if (name == "adsr")         return std::make_unique<AdsrKernel>();
+        if (name == "envelope")     return std::make_unique<EnvelopeKernel>();
+        if (name == "shaper-soft")  return std::make_unique<ShaperKernel> (0);
+        if (name == "shaper-tube")  return std::make_unique<ShaperKernel> (1);
+        if (name == "shaper-tape")  return std::make_unique<ShaperKernel> (2);
+        if (name == "eq")           return std::make_unique<EqKernel>();
+        if (name == "delay")        return std::make_unique<DelayKernel>();
+
+        if (name == "dynamics")
+            return std::make_unique<ContextKernel<soulbass::DynamicsProcessor>> ([] (soulbass::DynamicsProcessor& p)
+            {
+                p.setParameters (soulbass::DynamicsProcessor::Mode::compress, -18.0f, 4.0f, 10.0f, 80.0f, 0.0f);
+            });
+
+        if (name == "limiter")
+            return std::make_unique<ContextKernel<soulbass::DynamicsProcessor>> ([] (soulbass::DynamicsProcessor& p)
+            {
+                p.setParameters (soulbass::DynamicsProcessor::Mode::limit, -6.0f, 1.0f, 1.0f, 80.0f, 1.5f);
+            });
+
+        if (name == "chorus")
+            return std::make_unique<ContextKernel<soulbass::EnsembleChorus>> ([] (soulbass::EnsembleChorus& p)
+            {
+                p.setParameters (1.2f, 0.35f, soulbass::EnsembleChorus::maxVoices, 150.0f);
+            });
+
+        if (name == "reverb")
+            return std::make_unique<ContextKernel<juce::dsp::Reverb>> ([] (juce::dsp::Reverb& p)
+            {
+                juce::dsp::Reverb::Parameters params;
+                params.roomSize = 0.6f;
+                params.wetLevel = 0.25f;
+                params.dryLevel = 0.75f;
+                p.setParameters (params);
+            });
+
+        if (name == "reverb-conv")
+            return std::make_unique<ContextKernel<soulbass::ConvolutionReverb>> ([] (soulbass::ConvolutionReverb& p)
+            {
+                p.setParameters (soulbass::ConvolutionReverb::Impulse::plate, 1.5f, 0.25f);
+
+                // The impulse response loads in the background; let it land first.
+                juce::Thread::sleep (500);
+            });
+
+        return nullptr;
+    }
+
+    const char* const defaultKernels = "voice,voice-mod,voice-unison,voice-ladder,voice-sustain,svf,adsr,envelope,shaper-soft,shaper-tube,shaper-tape,"
+                                       "eq,dynamics,limiter,delay,chorus,reverb,reverb-conv";
+
+    //==============================================================================
+    struct Timings
+    {
+        double warmNsPerSample = 0.0;
+        double coldNsPerSample = 0.0;
+    };
+
+    class Runner
+    {
+    public:
+        Runner (double sampleRateIn) : sampleRate (sampleRateIn)
+        {
+            // Larger than any last-level cache we are likely to meet.
+            evictionBuffer.resize ((size_t) 64 * 1024 * 1024 / sizeof (float), 1.0f);
+        }
+
+        Timings run (Kernel& kernel, int blockSize)
+        {
+            kernel.prepare (sampleRate, blockSize);
+
+            juce::AudioBuffer<float> source (2, blockSize), work (2, blockSize);
+            juce::Random random (42);
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                    source.setSample (ch, i, (random.nextFloat() * 2.0f - 1.0f) * 0.5f);
+
+            // Every block starts from fresh input; the copy is timed alone and removed.
+            auto runBlock = [&]
+            {
+                work.makeCopyOf (source, true);
+                kernel.process (work);
+                checksum += work.getSample (0, blockSize - 1);
+            };
+
+            auto copyOnly = [&]
+            {
+                work.makeCopyOf (source, true);
+                checksum += work.getSample (0, blockSize - 1);
+            };
+
+            for (int i = 0; i < 200; ++i)
+                runBlock();
+
+            const auto blocksPerBatch = juce::jmax (1, (1 << 18) / blockSize);
+            const auto copyNs = medianBatchNs (copyOnly, blocksPerBatch);
+            const auto warmNs = medianBatchNs (runBlock, blocksPerBatch) - copyNs;
+
+            constexpr int coldBlocks = 100;
+            double coldTotal = 0.0;
+
+            for (int i = 0; i < coldBlocks; ++i)
+            {
+                evictCaches();
+                coldTotal += timeNs ([&] { runBlock(); });
+            }
+
+            const auto coldNs = coldTotal / coldBlocks - copyNs / blocksPerBatch;
+
+            return { juce::jmax (0.0, warmNs / ((double) blocksPerBatch * blockSize)),
+                     juce::jmax (0.0, coldNs / blockSize) };
+        }
+
+        double getChecksum() const noexcept { return checksum; }
+
+    private:
+        template <typename Fn>
+        static double timeNs (Fn&& fn)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            fn();
+            return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e9;
+        }
+
+        template <typename Fn>
+        static double medianBatchNs (Fn&& fn, int blocksPerBatch)
+        {
+            std::vector<double> batches;
+
+            for (int repeat = 0; repeat < 7; ++repeat)
+                batches.push_back (timeNs ([&] { for (int b = 0; b < blocksPerBatch; ++b) fn(); }));
+
+            return soulbass::tools::percentile (batches, 50.0);
+        }
+
+        void evictCaches()
+        {
+            float sum = 0.0f;
+            for (size_t i = 0; i < evictionBuffer.size(); i += 16)
+            {
+                evictionBuffer[i] += 1.0f;
+                sum += evictionBuffer[i];
+            }
+            checksum += sum * 1.0e-12;
+        }
+
+        double sampleRate;
+        std::vector<float> evictionBuffer;
+        double checksum = 0.0;
+    };
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    const juce::ArgumentList args (argc, argv);
+
+    auto option = [&args] (const char* name, const char* fallback)
+    {
+        const auto value = args.getValueForOption (name);
+        return value.isNotEmpty() ? value : juce::String (fallback);
+    };
+
+    const auto kernelNames = juce::StringArray::fromTokens (option ("--kernels", defaultKernels), ",", "");
+    const auto blocks = soulbass::tools::parseIntList (option ("--blocks", "16,64,256,1024"));
+    const auto sampleRate = option ("--rate", "48000").getDoubleValue();
+
+    Runner runner (sampleRate);
+    juce::Array<juce::var> results;
+
+    std::cout << juce::String::formatted ("%-14s %6s %14s %14s\n", "kernel", "block", "warm ns/smp", "cold ns/smp");
+
+    for (auto& name : kernelNames)
+    {
+        auto kernel = createKernel (name.trim());
+        if (kernel == nullptr)
+        {
+            std::cerr << "unknown kernel: " << name << std::endl;
+            return 1;
+        }
+
+        for (auto block : blocks)
+        {
+            const auto t = runner.run (*kernel, block);
+            std::cout << juce::String::formatted ("%-14s %6d %14.3f %14.3f\n",
+                                                  name.trim().toRawUTF8(), block, t.warmNsPerSample, t.coldNsPerSample);
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty ("kernel", name.trim());
+            result->setProperty ("blockSize", block);
+            result->setProperty ("warmNsPerSample", t.warmNsPerSample);
+            result->setProperty ("coldNsPerSample", t.coldNsPerSample);
+            results.add (result);
+        }
+    }
+
+    // Printing the checksum keeps the optimiser from discarding the work.
+    std::cout << "checksum " << runner.getChecksum() << std::endl;
+
+    const auto jsonPath = args.getValueForOption ("--json");
+    if (jsonPath.isNotEmpty())
+    {
+        auto* report = new juce::DynamicObject();
+        report->setProperty ("tool", "soulbass-kernels");
+        report->setProperty ("sampleRate", sampleRate);
+        report->setProperty ("results", results);
+
+        if (! juce::File::getCurrentWorkingDirectory().getChildFile (jsonPath).replaceWithText (juce::JSON::toString (juce::var (report))))
+        {
+            std::cerr << "could not write " << jsonPath << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,288 @@
+// soulbass-render: bounces MIDI files to WAV through SoulBassAudioProcessor as fast
+// as the CPU allows.
+//
+//   soulbass-render [--state=preset.xml] [--rate=48000] [--block=512] [--tail=2]
+//                   [--bits=24] [--jobs=N] [--output-dir=.] song.mid [more.mid ...]
+//
+// --state takes either a saved state blob (as written by getStateInformation) or
+// the parameter XML itself. Files are shared out between --jobs worker threads
+// (default: one per core), each with its own processor; the decoded samples are
+// shared by all of them through SampleLibrary. Every MIDI file is rendered from a
+// clean state to <output-dir>/<name>.wav.
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#include <iostream>
+
+namespace
+{
+    struct RenderSettings
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        double tailSeconds = 2.0;
+        int bitsPerSample = 24;
+        juce::File outputDir;
+        juce::MemoryBlock state;
+    };
+
+    juce::CriticalSection outputLock;
+
+    void log (const juce::String& message)
+    {
+        const juce::ScopedLock sl (outputLock);
+        std::cerr << message << std::endl;
+    }
+
+    //==============================================================================
+    // Accepts a state blob or plain XML; returns the blob form, or nothing if the
+    // file isn't a SoulBass state.
+    bool loadState (const juce::File& file, const juce::Identifier& expectedType, juce::MemoryBlock& result)
+    {
+        juce::MemoryBlock data;
+        if (! file.loadFileAsData (data))
+            return false;
+
+        auto xml = juce::AudioProcessor::getXmlFromBinary (data.getData(), (int) data.getSize());
+        if (xml == nullptr)
+            xml = juce::parseXML (data.toString());
+
+        if (xml == nullptr || ! xml->hasTagName (expectedType.toString()))
+            return false;
+
+        juce::AudioProcessor::copyXmlToBinary (*xml, result);
+        return true;
+    }
+
+    bool readMidiFile (const juce::File& file, juce::MidiMessageSequence& result)
+    {
+        juce::FileInputStream stream (file);
+        juce::MidiFile midiFile;
+
+        if (! stream.openedOk() || ! midiFile.readFrom (stream))
+            return false;
+
+        midiFile.convertTimestampTicksToSeconds();
+
+        for (int t = 0; t < midiFile.getNumTracks(); ++t)
+            result.addSequence (*midiFile.getTrack (t), 0.0);
+
+        result.updateMatchedPairs();
+        return true;
+    }
+
+    bool writeWav (const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate, int bitsPerSample)
+    {
+        file.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream> (file);
+        if (! stream->openedOk())
+            return false;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), sampleRate,
+                                                                              (unsigned int) buffer.getNumChannels(),
+                                                                              bitsPerSample, {}, 0));
+        if (writer == nullptr)
+            return false;
+
+        stream.release();
+        return writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+    }
+
+    //==============================================================================
+    // One processor per worker, reused for every file the worker picks up.
+    class RenderWorker : public juce::Thread
+    {
+    public:
+        RenderWorker (int index, int voiceWorkers, const RenderSettings& settingsIn, const juce::Array<juce::File>& filesIn,
+                      std::atomic<int>& nextFileIn, std::atomic<int>& failuresIn)
+            : juce::Thread ("SoulBass Render " + juce::String (index)),
+              settings (settingsIn), files (filesIn), nextFile (nextFileIn), failures (failuresIn)
+        {
+            processor.setMaxVoiceWorkers (voiceWorkers);
+        }
+
+        void run() override
+        {
+            for (auto i = nextFile.fetch_add (1); i < files.size() && ! threadShouldExit(); i = nextFile.fetch_add (1))
+                if (! render (files.getReference (i)))
+                    ++failures;
+
+            processor.releaseResources();
+        }
+
+    private:
+        bool render (const juce::File& midiFile)
+        {
+            juce::MidiMessageSequence sequence;
+            if (! readMidiFile (midiFile, sequence))
+            {
+                log ("could not read " + midiFile.getFullPathName());
+                return false;
+            }
+
+            if (! settings.state.isEmpty())
+                processor.setStateInformation (settings.state.getData(), (int) settings.state.getSize());
+
+            processor.getSynth().allNotesOff (0, false);
+            processor.releaseResources();
+            processor.setNonRealtime (true);
+            processor.setPlayConfigDetails (0, 2, settings.sampleRate, settings.blockSize);
+            processor.prepareToPlay (settings.sampleRate, settings.blockSize);
+
+            const auto totalSamples = (int) std::ceil ((sequence.getEndTime() + settings.tailSeconds) * settings.sampleRate);
+            juce::AudioBuffer<float> output (2, totalSamples), block (2, settings.blockSize);
+            juce::MidiBuffer midi;
+            int nextEvent = 0;
+
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+
+            // The output is delayed by the processor's latency (lookahead, oversampling,
+            // sub-blocks), which it reports once it has seen a block. The first latency
+            // samples are dropped and as many again rendered past the end, so the file
+            // lines up with the MIDI and keeps its whole tail.
+            auto latency = processor.getLatencySamples();
+
+            for (int position = 0; position < totalSamples + latency; position += settings.blockSize)
+            {
+                const auto num = juce::jmin (settings.blockSize, totalSamples + latency - position);
+                block.setSize (2, num, false, false, true);
+                midi.clear();
+
+                // The previous file may have left the wheels anywhere.
+                if (position == 0)
+                {
+                    for (int channel = 1; channel <= 16; ++channel)
+                    {
+                        midi.addEvent (juce::MidiMessage::pitchWheel (channel, 8192), 0);
+                        midi.addEvent (juce::MidiMessage::controllerEvent (channel, 1, 0), 0);
+                    }
+                }
+
+                for (; nextEvent < sequence.getNumEvents(); ++nextEvent)
+                {
+                    const auto& message = sequence.getEventPointer (nextEvent)->message;
+                    const auto samplePosition = (int) std::llround (message.getTimeStamp() * settings.sampleRate);
+
+                    if (samplePosition >= position + num)
+                        break;
+
+                    midi.addEvent (message, juce::jmax (0, samplePosition - position));
+                }
+
+                processor.processBlock (block, midi);
+                latency = processor.getLatencySamples();
+
+                const auto skip = juce::jmax (0, latency - position);
+                const auto count = juce::jmin (num - skip, totalSamples - (position + skip - latency));
+
+                for (int ch = 0; ch < 2 && count > 0; ++ch)
+                    output.copyFrom (ch, position + skip - latency, block, ch, skip, count);
+            }
+
+            const auto elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+            const auto outputFile = settings.outputDir.getChildFile (midiFile.getFileNameWithoutExtension() + ".wav");
+
+            if (! writeWav (outputFile, output, settings.sampleRate, settings.bitsPerSample))
+            {
+                log ("could not write " + outputFile.getFullPathName());
+                return false;
+            }
+
+            const auto audioSeconds = (double) totalSamples / settings.sampleRate;
+            log (outputFile.getFileName() + ": " + juce::String (audioSeconds, 1) + " s of audio in "
+                 + juce::String (elapsedSeconds, 2) + " s (" + juce::String (audioSeconds / juce::jmax (1.0e-6, elapsedSeconds), 1) + "x)");
+            return true;
+        }
+
+        const RenderSettings& settings;
+        const juce::Array<juce::File>& files;
+        std::atomic<int>& nextFile;
+        std::atomic<int>& failures;
+
+        SoulBassAudioProcessor processor;
+    };
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    const juce::ArgumentList args (argc, argv);
+
+    auto option = [&args] (const char* name, const char* fallback)
+    {
+        const auto value = args.getValueForOption (name);
+        return value.isNotEmpty() ? value : juce::String (fallback);
+    };
+
+    juce::Array<juce::File> files;
+    for (auto& arg : args.arguments)
+        if (! arg.isOption())
+            files.add (arg.resolveAsFile());
+
+    if (files.isEmpty())
+    {
+        std::cerr << "usage: soulbass-render [--state=file] [--rate=48000] [--block=512] [--tail=2] "
+                     "[--bits=24] [--jobs=N] [--output-dir=.] file.mid..." << std::endl;
+        return 2;
+    }
+
+    RenderSettings settings;
+    settings.sampleRate = option ("--rate", "48000").getDoubleValue();
+    settings.blockSize = juce::jlimit (1, 65536, option ("--block", "512").getIntValue());
+    settings.tailSeconds = juce::jmax (0.0, option ("--tail", "2").getDoubleValue());
+    settings.bitsPerSample = option ("--bits", "24").getIntValue();
+    settings.outputDir = juce::File::getCurrentWorkingDirectory().getChildFile (option ("--output-dir", "."));
+
+    if (settings.sampleRate < 8000.0 || ! (settings.bitsPerSample == 16 || settings.bitsPerSample == 24 || settings.bitsPerSample == 32))
+    {
+        std::cerr << "bad --rate or --bits (16, 24 or 32)" << std::endl;
+        return 2;
+    }
+
+    if (settings.outputDir.createDirectory().failed())
+    {
+        std::cerr << "could not create " << settings.outputDir.getFullPathName() << std::endl;
+        return 2;
+    }
+
+    const auto statePath = args.getValueForOption ("--state");
+    if (statePath.isNotEmpty())
+    {
+        // Root tag of the processor's parameter tree (see the apvts constructor).
+        const auto stateFile = juce::File::getCurrentWorkingDirectory().getChildFile (statePath);
+
+        if (! loadState (stateFile, "PARAMETERS", settings.state))
+        {
+            std::cerr << "not a SoulBass state or preset: " << stateFile.getFullPathName() << std::endl;
+            return 2;
+        }
+    }
+
+    const auto numJobs = juce::jlimit (1, files.size(), option ("--jobs", juce::String (juce::SystemStats::getNumCpus()).toRawUTF8()).getIntValue());
+
+    // The processors are created here on the main thread; each worker only ever
+    // touches its own.
+    std::atomic<int> nextFile { 0 }, failures { 0 };
+    std::vector<std::unique_ptr<RenderWorker>> workers;
+
+    // Cores left over once every file job has one go to rendering voices in parallel.
+    const auto voiceWorkers = juce::jmax (0, juce::SystemStats::getNumCpus() / numJobs - 1);
+
+    for (int i = 0; i < numJobs; ++i)
+        workers.push_back (std::make_unique<RenderWorker> (i, voiceWorkers, settings, files, nextFile, failures));
+
+    const auto start = juce::Time::getMillisecondCounterHiRes();
+
+    for (auto& worker : workers)
+        worker->startThread();
+
+    for (auto& worker : workers)
+        worker->waitForThreadToExit (-1);
+
+    std::cerr << files.size() << " file(s) on " << numJobs << " worker(s) in "
+              << juce::String ((juce::Time::getMillisecondCounterHiRes() - start) * 0.001, 2) << " s" << std::endl;
+
+    return failures.load() == 0 ? 0 : 1;
+}